@@ -89,10 +89,6 @@ rm -rf %{buildroot}
 %find_lang %{name}
 
 %post
-# todo properly use systemd --user
-#ln -s /lib/systemd/user/askuser-notification.service \
-#/usr/lib/systemd/user/default.target.wants/askuser-notification.service 2> /dev/null
-
 systemctl daemon-reload
 
 #if [ $1 = 1 ]; then
@@ -128,7 +124,7 @@ systemctl restart cynara.service
 %manifest askuser-notification.manifest
 %license LICENSE
 %attr(755,root,root) /usr/bin/askuser-notification
-#/usr/lib/systemd/user/askuser-notification.service
+/usr/lib/systemd/user/askuser-notification.service
 /usr/share/locale/en/LC_MESSAGES/askuser.mo
 /usr/share/locale/pl/LC_MESSAGES/askuser.mo
 
@@ -148,4 +144,5 @@ systemctl restart cynara.service
 %license LICENSE
 %attr(755,root,root) /usr/bin/askuser-test
 %attr(755,root,root) /usr/bin/askuser-tests
+%attr(755,root,root) /usr/bin/askuser-benchmark
 
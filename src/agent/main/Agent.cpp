@@ -28,6 +28,8 @@
 #include <utility>
 
 #include <attributes/attributes.h>
+#include <label/Label.h>
+#include <label/PackageResolver.h>
 #include <translator/Translator.h>
 #include <types/AgentErrorMsg.h>
 #include <types/SupportedTypes.h>
@@ -156,10 +158,7 @@ void Agent::processCynaraRequest(Request *request) {
     auto existingRequest = m_requests.find(request->id());
     if (existingRequest != m_requests.end()) {
         if (request->type() == RT_Cancel) {
-            delete existingRequest->second;
-            m_requests.erase(existingRequest);
-            m_cynaraTalker.sendResponse(request->type(), request->id());
-            dismissUI(request->id());
+            cancelRequest(request->id());
         } else {
             ALOGE("Incoming request with ID: [" << request->id() << "] is being already processed");
         }
@@ -171,19 +170,91 @@ void Agent::processCynaraRequest(Request *request) {
         return;
     }
 
-    if (!startUIForRequest(request)) {
-        auto data = Translator::Agent::answerToData(Cynara::PolicyType(), AgentErrorMsg::Error);
-        m_cynaraTalker.sendResponse(RT_Action, request->id(), data);
-        return;
+    auto data = Translator::Agent::dataToRequest(request->data());
+    std::string package = Label::packageKey(data.client, Label::securityManagerPackage);
+    std::string key = promptKey(package, data);
+
+    if (!joinPrompt(request, key)) {
+        if (!startUIForRequest(request, data, package)) {
+            auto answer = Translator::Agent::answerToData(Cynara::PolicyType(),
+                                                          AgentErrorMsg::Error);
+            m_cynaraTalker.sendResponse(RT_Action, request->id(), answer);
+            return;
+        }
+        m_prompts[request->id()].key = key;
+        m_promptByKey[key] = request->id();
     }
 
     m_requests.insert(std::make_pair(request->id(), request));
     requestPtr.release();
 }
 
+bool Agent::joinPrompt(Request *request, const std::string &key) {
+    auto promptIt = m_promptByKey.find(key);
+    if (promptIt == m_promptByKey.end())
+        return false;
+
+    ALOGD("Request [" << request->id() << "] waits for answer to [" << promptIt->second << "]");
+    m_prompts[promptIt->second].followers.push_back(request->id());
+    return true;
+}
+
+void Agent::cancelRequest(RequestId requestId) {
+    auto requestIt = m_requests.find(requestId);
+    delete requestIt->second;
+    m_requests.erase(requestIt);
+    m_cynaraTalker.sendResponse(RT_Cancel, requestId);
+
+    auto promptIt = m_prompts.find(requestId);
+    if (promptIt != m_prompts.end()) {
+        // Prompt is still awaited by requests that joined it
+        if (!promptIt->second.followers.empty())
+            return;
+        finishPrompt(requestId);
+        dismissUI(requestId);
+        return;
+    }
+
+    for (auto &prompt : m_prompts) {
+        auto &followers = prompt.second.followers;
+        for (auto it = followers.begin(); it != followers.end(); ++it) {
+            if (*it == requestId) {
+                followers.erase(it);
+                // Prompt was kept only for this follower
+                if (followers.empty() && m_requests.find(prompt.first) == m_requests.end()) {
+                    RequestId promptId = prompt.first;
+                    finishPrompt(promptId);
+                    dismissUI(promptId);
+                }
+                return;
+            }
+        }
+    }
+}
+
+void Agent::finishPrompt(RequestId promptId) {
+    auto promptIt = m_prompts.find(promptId);
+    if (promptIt == m_prompts.end())
+        return;
+
+    m_promptByKey.erase(promptIt->second.key);
+    m_prompts.erase(promptIt);
+}
+
 void Agent::processUIResponse(const Response &response) {
-    auto requestIt = m_requests.find(response.id());
-    if (requestIt != m_requests.end()) {
+    std::vector<RequestId> answered(1, response.id());
+    auto promptIt = m_prompts.find(response.id());
+    if (promptIt != m_prompts.end()) {
+        answered.insert(answered.end(), promptIt->second.followers.begin(),
+                        promptIt->second.followers.end());
+        finishPrompt(response.id());
+    }
+
+    for (RequestId requestId : answered) {
+        auto requestIt = m_requests.find(requestId);
+        if (requestIt == m_requests.end())
+            continue;
+
         Cynara::PluginData pluginData;
         if (response.type() == URT_ERROR) {
             pluginData = Translator::Agent::answerToData(Cynara::PolicyType(),
@@ -204,15 +275,15 @@ void Agent::processUIResponse(const Response &response) {
     dismissUI(response.id());
 }
 
-bool Agent::startUIForRequest(Request *request) {
-    auto data = Translator::Agent::dataToRequest(request->data());
-
+bool Agent::startUIForRequest(Request *request, const RequestData &data,
+                              const std::string &package) {
     AskUIInterfacePtr ui(new NotificationBackend());
 
     auto handler = [&](RequestId requestId, UIResponseType resultType) -> void {
                        UIResponseHandler(requestId, resultType);
                    };
-    bool ret = ui->start(data.client, data.user, data.privilege, request->id(), handler);
+    bool ret = ui->start(data.client, package, data.user, data.privilege, request->id(),
+                         handler);
     if (ret) {
         m_UIs.insert(std::make_pair(request->id(), std::move(ui)));
     }
@@ -258,6 +329,8 @@ Cynara::PolicyType Agent::UIResponseToPolicyType(UIResponseType responseType) {
             return AskUser::SupportedTypes::Client::ALLOW_PER_SESSION;
         case URT_YES_LIFE:
             return AskUser::SupportedTypes::Client::ALLOW_PER_LIFE;
+        case URT_YES_TIMED:
+            return AskUser::SupportedTypes::Client::ALLOW_TIMED;
         case URT_NO_ONCE:
             return AskUser::SupportedTypes::Client::DENY_ONCE;
         case URT_NO_SESSION:
@@ -269,6 +342,15 @@ Cynara::PolicyType Agent::UIResponseToPolicyType(UIResponseType responseType) {
     }
 }
 
+std::string Agent::promptKey(const std::string &package, const RequestData &data) {
+    std::string key = package;
+    key.push_back('\0');
+    key.append(data.user);
+    key.push_back('\0');
+    key.append(data.privilege);
+    return key;
+}
+
 } // namespace Agent
 
 } // namespace AskUser
@@ -26,7 +26,10 @@
 #include <map>
 #include <mutex>
 #include <queue>
+#include <string>
+#include <vector>
 #include <types/PolicyType.h>
+#include <types/RequestData.h>
 
 #include <main/CynaraTalker.h>
 #include <main/Request.h>
@@ -59,12 +62,24 @@ private:
     static volatile sig_atomic_t m_stopFlag;
     std::map<RequestId, AskUIInterfacePtr> m_UIs;
 
+    // Requests for the same package, user and privilege share one prompt
+    struct Prompt {
+        std::string key;
+        std::vector<RequestId> followers;
+    };
+    std::map<RequestId, Prompt> m_prompts;
+    std::map<std::string, RequestId> m_promptByKey;
+
     void init();
     void finish();
 
     void requestHandler(Request *request);
     void processCynaraRequest(Request *request);
-    bool startUIForRequest(Request *request);
+    bool startUIForRequest(Request *request, const RequestData &data,
+                           const std::string &package);
+    bool joinPrompt(Request *request, const std::string &key);
+    void cancelRequest(RequestId requestId);
+    void finishPrompt(RequestId promptId);
     void UIResponseHandler(RequestId requestId, UIResponseType responseType);
 
     void processUIResponse(const Response &response);
@@ -72,6 +87,7 @@ private:
     void dismissUI(RequestId requestId);
 
     static Cynara::PolicyType UIResponseToPolicyType(UIResponseType responseType);
+    static std::string promptKey(const std::string &package, const RequestData &data);
 };
 
 } // namespace Agent
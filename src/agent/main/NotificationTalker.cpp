@@ -22,14 +22,23 @@
 #include "NotificationTalker.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <cynara-creds-socket.h>
+#include <iterator>
+#include <memory>
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <exception/ErrnoException.h>
 #include <exception/CynaraException.h>
+#include <exception/Exception.h>
 #include <log/alog.h>
 #include <socket/Socket.h>
 #include <translator/Translator.h>
+#include <config/Limits.h>
 #include <config/Path.h>
 #include <types/Protocol.h>
 
@@ -37,10 +46,40 @@ namespace AskUser {
 
 namespace Agent {
 
-NotificationTalker::NotificationTalker() : m_failed(true), m_stopflag(false)
+namespace {
+
+const std::size_t COMMANDS_CAPACITY = 1024;
+
+// Notification daemon is started again, if it did not connect in this time
+const std::chrono::seconds ACTIVATION_RETRY(10);
+const int ACTIVATION_RETRY_MS =
+        std::chrono::duration_cast<std::chrono::milliseconds>(ACTIVATION_RETRY).count();
+// Until systemctl starting notification daemon ends, its status is checked this often
+const int STARTER_CHECK_MS = 100;
+const char SYSTEMCTL_PATH[] = "/usr/bin/systemctl";
+const char NOTIFICATION_SERVICE[] = "askuser-notification.service";
+
+// Requests of one package share popup, client whose package is not known is its own one
+const std::string &packageOf(const NotificationRequest &request)
+{
+    return request.package.empty() ? request.data.client : request.package;
+}
+
+} // namespace
+
+NotificationTalker::NotificationTalker(Heartbeat heartbeat, Socket::Type socketType)
+    : m_failed(true), m_heartbeat(heartbeat),
+      m_nextHeartbeat(std::chrono::steady_clock::time_point::max()),
+      m_commands(COMMANDS_CAPACITY), m_overflowing(false), m_stopflag(false)
 {
     try {
-        m_sockfd = Socket::listen(Path::getSocketPath());
+        m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_eventFd == -1)
+            throw ErrnoException("Creating eventfd failed");
+        m_poller.add(m_eventFd);
+
+        m_sockfd = Socket::listen(Path::getSocketPath(), socketType);
+        m_poller.add(m_sockfd);
         m_thread = std::thread(&NotificationTalker::run, this);
         m_failed = false;
     } catch (const Exception &e) {
@@ -59,8 +98,6 @@ void NotificationTalker::setErrorMsg(std::string s)
 
 void NotificationTalker::parseRequest(RequestType type, NotificationRequest request)
 {
-    std::lock_guard<std::mutex> lock(m_bfLock);
-
     if (!m_responseHandler) {
         ALOGE("Response handler not set!");
         return;
@@ -72,129 +109,286 @@ void NotificationTalker::parseRequest(RequestType type, NotificationRequest requ
         stop();
         return;
     case RequestType::RT_Action:
-        ALOGD("Add request: " << request.id);
-        addRequest(std::move(request));
-        return;
     case RequestType::RT_Cancel:
-        ALOGD("Cancel request: " << request.id);
-        removeRequest(request.id);
-        return;
+        break;
     default:
         return;
     }
+
+    // Once ring is full, later commands follow to overflow list until talker takes it
+    TalkerCommand command(type, std::move(request));
+    if (m_overflowing || !m_commands.push(std::move(command))) {
+        std::lock_guard<std::mutex> lock(m_overflowLock);
+        if (m_overflow.empty())
+            ALOGW("Too many pending commands, queueing them under lock");
+        m_overflow.push_back(std::move(command));
+        m_overflowing = true;
+    }
+
+    wakeUp();
 }
 
-void NotificationTalker::addRequest(NotificationRequest &&request)
+void NotificationTalker::wakeUp()
 {
-    auto &queue = m_requests[request.data.user];
-    auto it = std::find_if(queue.begin(), queue.end(),
-            [&request](const NotificationRequest &req){return req.id == request.id;}
-        );
+    uint64_t one = 1;
+    if (m_eventFd != -1 && TEMP_FAILURE_RETRY(::write(m_eventFd, &one, sizeof(one))) == -1
+        && errno != EAGAIN) {
+        ALOGE("Waking up notification loop failed: " << errno);
+    }
+}
 
-    if (it == queue.end()) {
-        queue.emplace_back(std::move(request));
+void NotificationTalker::runCommands()
+{
+    uint64_t count;
+    if (TEMP_FAILURE_RETRY(::read(m_eventFd, &count, sizeof(count))) == -1 && errno != EAGAIN)
+        throw ErrnoException("Reading eventfd failed");
+
+    TalkerCommand command;
+    while (m_commands.pop(command))
+        runCommand(command);
+
+    // Ring is empty, so whatever overflowed is next in order
+    if (m_overflowing) {
+        for (auto &overflowed : takeOverflow())
+            runCommand(overflowed);
+    }
+}
+
+void NotificationTalker::runCommand(TalkerCommand &command)
+{
+    if (command.type == RequestType::RT_Action) {
+        ALOGD("Add request: " << command.request.id);
+        addRequest(std::move(command.request));
     } else {
+        ALOGD("Cancel request: " << command.request.id);
+        removeRequest(command.request.id);
+    }
+}
+
+std::vector<TalkerCommand> NotificationTalker::takeOverflow()
+{
+    std::vector<TalkerCommand> commands;
+    std::lock_guard<std::mutex> lock(m_overflowLock);
+    commands.swap(m_overflow);
+    m_overflowing = false;
+    return commands;
+}
+
+void NotificationTalker::addRequest(NotificationRequest &&request)
+{
+    if (m_requestIndex.find(request.id) != m_requestIndex.end()) {
         ALOGD("Cynara request already exists");
+        return;
+    }
+
+    // Request which does not fit into a frame would never reach the daemon
+    std::size_t size = Translator::Gui::notificationRequestsDataSize(
+            1, Translator::Gui::notificationRequestDataSize(request));
+    if (sizeof(Protocol::requestCode) + size > Limits::getSizeLimit()) {
+        ALOGE("Notification request of " << size << " bytes exceeds size limit");
+        m_responseHandler({request.id, NResponseType::Error});
+        return;
     }
+
+    auto userIt = m_requests.insert(std::make_pair(request.data.user, UserQueue())).first;
+    auto &queue = userIt->second.requests;
+    RequestId id = request.id;
+    queue.emplace_back(std::move(request));
+    m_requestIndex[id] = {userIt, std::prev(queue.end()), -1};
+
+    sendNext(userIt);
 }
 
 void NotificationTalker::removeRequest(RequestId id)
 {
-    for (auto &pair : m_requests) {
-        auto &queue = std::get<1>(pair);
-        auto it = std::find_if(queue.begin(), queue.end(),
-                [&id](const NotificationRequest &req){return req.id == id;}
-            );
-        if (it == queue.end()) {
-            ALOGW("Removing non-existent request");
-            return;
-        }
-        if (it == queue.begin()) {
-            auto user = std::get<0>(pair);
-            auto it2 = m_userToFd.find(user);
-            if (it2 != m_userToFd.end())
-                sendDismiss(std::get<1>(*it2));
-        }
+    auto indexIt = m_requestIndex.find(id);
+    if (indexIt == m_requestIndex.end()) {
+        ALOGW("Removing non-existent request");
+        return;
+    }
+
+    auto location = indexIt->second;
+    UserQueue &queue = location.user->second;
+    m_requestIndex.erase(indexIt);
 
-        queue.erase(it);
+    if (location.fd == -1) {
+        queue.requests.erase(location.request);
+        return;
     }
+
+    queue.inFlight.erase(location.request);
+    --m_connections[location.fd].inFlight;
+    sendDismiss(location.fd, id);
+    sendNext(location.user);
 }
 
 void NotificationTalker::stop()
 {
     m_stopflag = true;
+    wakeUp();
 }
 
 void NotificationTalker::clear()
 {
-    for (auto& pair : m_fdStatus) {
-        int fd = std::get<0>(pair);
-        Socket::close(fd);
+    for (auto &conn : m_connections) {
+        if (conn.fd != -1)
+            Socket::close(conn.fd);
     }
+    m_connections.clear();
+    m_bells.clear();
 
-    m_fdStatus.clear();
-    m_fdToUser.clear();
-    m_userToFd.clear();
+    for (auto &pair : m_requests)
+        pair.second.connections.clear();
 
-    Socket::close(m_sockfd);
-    m_sockfd = 0;
+    if (m_sockfd != -1) {
+        Socket::close(m_sockfd);
+        m_sockfd = -1;
+    }
 }
 
 NotificationTalker::~NotificationTalker()
 {
-    stop();
+    NotificationTalker::stop();
+    if (m_thread.joinable())
+        m_thread.join();
     clear();
-    m_thread.join();
+
+    if (m_eventFd != -1)
+        ::close(m_eventFd);
 }
 
-void NotificationTalker::sendRequest(int fd, const NotificationRequest &request)
+void NotificationTalker::sendRequests(int fd, const std::vector<NotificationRequest> &requests)
 {
-    m_fdStatus[fd] = false;
+    std::string data = Translator::Gui::notificationRequestsToData(requests);
+    sendMessage(m_connections[fd], &Protocol::requestCode, sizeof(Protocol::requestCode),
+                data.data(), data.size());
+}
 
-    std::string data = Translator::Gui::notificationRequestToData(request.id,
-                                                                  request.data.client,
-                                                                  request.data.privilege);
-    auto size = data.size();
+void NotificationTalker::sendDismiss(int fd, RequestId id)
+{
+    sendMessage(m_connections[fd], &Protocol::dissmisCode, sizeof(Protocol::dissmisCode),
+                &id, sizeof(id));
+}
 
-    if (!Socket::send(fd, &size, sizeof(size))) {
-        remove(fd);
+void NotificationTalker::sendAck(int fd, RequestId id)
+{
+    sendMessage(m_connections[fd], &Protocol::ackCode, sizeof(Protocol::ackCode),
+                &id, sizeof(id));
+}
+
+void NotificationTalker::sendPing(int fd)
+{
+    sendMessage(m_connections[fd], &Protocol::pingCode, sizeof(Protocol::pingCode));
+}
+
+void NotificationTalker::sendMessage(Connection &conn, const void *head, std::size_t headSize,
+                                     const void *body, std::size_t bodySize)
+{
+    if (!conn.channel.send(head, headSize, body, bodySize)) {
+        remove(conn.fd);
         return;
     }
 
-    if (!Socket::send(fd, data.c_str(), size)) {
-        remove(fd);
+    // Output is bounded, as only requests in window, their dismisses and acks are sent
+    watchOutput(conn);
+}
+
+void NotificationTalker::flush(Connection &conn)
+{
+    if (!conn.channel.flush()) {
+        remove(conn.fd);
         return;
     }
+
+    watchOutput(conn);
 }
 
-void NotificationTalker::sendDismiss(int fd)
+void NotificationTalker::watchOutput(Connection &conn)
 {
-    if (!m_fdStatus[fd]) {
-        if (!Socket::send(fd, &Protocol::dissmisCode, sizeof(Protocol::dissmisCode))) {
-            remove(fd);
+    // Shared ring wakes the loop through bell when it has room again
+    bool writing = conn.channel.socketOutputPending();
+    if (writing == conn.writing)
+        return;
+
+    conn.writing = writing;
+    m_poller.modify(conn.fd, writing ? Socket::Poller::Read | Socket::Poller::Write
+                                     : Socket::Poller::Read);
+}
+
+void NotificationTalker::sendNext(RequestsQueue::iterator user)
+{
+    UserQueue &queue = user->second;
+
+    if (queue.connections.empty()) {
+        if (!queue.requests.empty())
+            activate(user);
+        return;
+    }
+
+    while (!queue.requests.empty()) {
+        // Least loaded connection of the user, which has room in its window
+        Connection *conn = nullptr;
+        for (int fd : queue.connections) {
+            Connection &candidate = m_connections[fd];
+            if (candidate.inFlight < Protocol::requestWindow
+                && (!conn || candidate.inFlight < conn->inFlight)) {
+                conn = &candidate;
+            }
+        }
+        if (!conn)
             return;
+
+        // Other waiting requests of the same package go along, so they share one popup.
+        // Each of them takes its place in the window and group stays within one frame.
+        std::vector<NotificationRequest> group;
+        // Data size of requests in group
+        std::size_t groupSize = 0;
+        const std::string package = packageOf(queue.requests.front());
+        const std::size_t groupLimit = std::min(Protocol::requestGroupLimit,
+                                                Protocol::requestWindow - conn->inFlight);
+        for (auto it = queue.requests.begin();
+             it != queue.requests.end() && group.size() < groupLimit;) {
+            auto requestIt = it++;
+            if (packageOf(*requestIt) != package)
+                continue;
+
+            // Each request alone fits, as larger ones are refused when added
+            std::size_t requestSize = Translator::Gui::notificationRequestDataSize(*requestIt);
+            std::size_t frameSize = sizeof(Protocol::requestCode)
+                    + Translator::Gui::notificationRequestsDataSize(group.size() + 1,
+                                                                    groupSize + requestSize);
+            if (!group.empty() && frameSize > Limits::getSizeLimit())
+                break;
+            groupSize += requestSize;
+
+            queue.inFlight.splice(queue.inFlight.end(), queue.requests, requestIt);
+            m_requestIndex[requestIt->id].fd = conn->fd;
+            ++conn->inFlight;
+            group.push_back(*requestIt);
         }
-        m_fdStatus[fd] = true;
+        m_nextHeartbeat = std::min(m_nextHeartbeat, conn->heard + m_heartbeat.interval);
+
+        // Failed send drops connection and moves its requests back
+        sendRequests(conn->fd, group);
     }
 }
 
 void NotificationTalker::parseResponse(NotificationResponse response, int fd)
 {
-    auto &queue = m_requests[m_fdToUser[fd]];
-    if (queue.empty()) {
+    Connection &conn = m_connections[fd];
+    auto indexIt = m_requestIndex.find(response.id);
+    if (indexIt == m_requestIndex.end() || indexIt->second.fd != fd) {
         ALOGD("Request canceled");
-        m_fdStatus[fd] = true;
         return;
     }
 
-    NotificationRequest request = queue.front();
-    if (request.id != response.id) {
-        ALOGD("Request canceled");
-        m_fdStatus[fd] = true;
-        return;
-    }
+    auto user = conn.user;
+    UserRequests &inFlight = user->second.inFlight;
+    NotificationRequest request = std::move(*indexIt->second.request);
+    inFlight.erase(indexIt->second.request);
+    m_requestIndex.erase(indexIt);
+    --conn.inFlight;
 
-    queue.pop_front();
     ALOGD("For user: <" << request.data.user
           << "> client: <" << request.data.client
           << "> privilege: <" << request.data.privilege
@@ -202,109 +396,381 @@ void NotificationTalker::parseResponse(NotificationResponse response, int fd)
 
     m_responseHandler(response);
 
-    if (!Socket::send(fd, &Protocol::ackCode, sizeof(Protocol::ackCode))) {
+    sendAck(fd, response.id);
+    sendNext(user);
+}
+
+void NotificationTalker::recvResponse(int fd)
+{
+    Connection &conn = m_connections[fd];
+    if (!conn.channel.receive()) {
         remove(fd);
         return;
     }
 
-    m_fdStatus[fd] = true;
+    conn.heard = std::chrono::steady_clock::now();
+    conn.pingSent = false;
+    takeResponses(fd);
 }
 
-void NotificationTalker::recvResponses(int &rv)
+void NotificationTalker::takeResponses(int fd)
 {
-    for (auto pair : m_userToFd) {
-        if (!rv) break;
-        int fd = std::get<1>(pair);
+    Connection &conn = m_connections[fd];
+    Socket::Frame frame;
+    while (conn.channel.nextFrame(frame)) {
+        NotificationResponse response;
+        if (frame.size != sizeof(response)) {
+            ALOGE("Malformed response from notification daemon");
+            remove(fd);
+            return;
+        }
+        memcpy(&response, frame.data, sizeof(response));
 
-        if (m_select.isSet(fd)) {
-            --rv;
+        // Pong only proves daemon is alive, which is already noted
+        if (response.response == NResponseType::Pong)
+            continue;
 
-            NotificationResponse response;
-            if (Socket::recv(fd, &response, sizeof(response))) {
-                parseResponse(response, fd);
-            } else {
-                remove(fd);
-            }
+        parseResponse(response, fd);
+        // Connection could be dropped while sending ack
+        if (!connection(fd))
+            return;
+    }
+
+    // Accepting offered rings sends confirmation to daemon
+    if (conn.bell == -1 && conn.channel.bell() != -1) {
+        conn.bell = conn.channel.bell();
+        m_poller.add(conn.bell);
+        m_bells[conn.bell] = fd;
+        ALOGD("Notification daemon of user: " << conn.user->first << " uses shared rings");
+    }
+    watchOutput(conn);
+}
+
+Connection *NotificationTalker::connection(int fd)
+{
+    if (fd < 0 || static_cast<std::size_t>(fd) >= m_connections.size()
+        || m_connections[fd].fd == -1) {
+        return nullptr;
+    }
+    return &m_connections[fd];
+}
+
+void NotificationTalker::newConnection()
+{
+    int fd = Socket::accept(m_sockfd);
+    try {
+        // Talker thread serves all users, so it must never block on one of them
+        Socket::setNonBlocking(fd);
+        std::string user = connectionUser(fd);
+
+        auto userIt = m_requests.insert(std::make_pair(user, UserQueue())).first;
+
+        m_poller.add(fd);
+        if (static_cast<std::size_t>(fd) >= m_connections.size())
+            m_connections.resize(fd + 1);
+
+        Connection &conn = m_connections[fd];
+        conn.fd = fd;
+        conn.channel = Socket::FramedConnection(fd);
+        conn.user = userIt;
+        conn.heard = std::chrono::steady_clock::now();
+        userIt->second.connections.push_back(fd);
+
+        ALOGD("Accepted new conection for user: " << user);
+        if (userIt->second.activating) {
+            auto coldStart = std::chrono::steady_clock::now() - userIt->second.activated;
+            ALOGI("Notification daemon for user: " << user << " connected "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(coldStart).count()
+                  << " ms after start");
+            userIt->second.activating = false;
+            --m_activations;
         }
+        userIt->second.restart = false;
+    } catch (...) {
+        Socket::close(fd);
+        throw;
     }
+
+    sendNext(m_connections[fd].user);
 }
 
-void NotificationTalker::newConnection(int &rv)
+void NotificationTalker::activate(RequestsQueue::iterator user)
 {
-    if (m_select.isSet(m_sockfd)) {
-        --rv;
-        int fd = Socket::accept(m_sockfd);
-        try {
-            char *user_c = nullptr;
+    UserQueue &queue = user->second;
+    auto now = std::chrono::steady_clock::now();
+    if (queue.activating && now - queue.activated < ACTIVATION_RETRY)
+        return;
 
-            int ret = cynara_creds_socket_get_user(fd, USER_METHOD_DEFAULT,&user_c);
+    if (!queue.activating) {
+        queue.activating = true;
+        ++m_activations;
+    }
+    queue.activated = now;
 
-            std::unique_ptr<char[]> userPtr(user_c);
+    startDaemon(user->first, queue.restart);
+}
 
-            if (ret != CYNARA_API_SUCCESS) {
-                throw CynaraException("cynara_creds_socket_get_user", ret);
-            }
-            std::string user = user_c;
+void NotificationTalker::retryActivations()
+{
+    for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+        if (!it->second.activating)
+            continue;
+
+        if (it->second.requests.empty()) {
+            it->second.activating = false;
+            --m_activations;
+        } else {
+            activate(it);
+        }
+    }
+}
 
-            auto it = m_userToFd.find(user);
-            if (it != m_userToFd.end())
-                remove(std::get<1>(*it));
+void NotificationTalker::startDaemon(const std::string &user, bool restart)
+{
+    // User is expected to be uid, it becomes part of machine name below
+    if (user.empty() || user.find_first_not_of("0123456789") != std::string::npos) {
+        ALOGE("Cannot start notification daemon for user <" << user << ">");
+        return;
+    }
 
-            m_userToFd[user] = fd;
-            m_fdToUser[fd] = user;
-            m_fdStatus[fd] = true;
+    // Agent runs as root, user's service manager is reached through its machine transport
+    std::string machine = "--machine=" + user + "@.host";
+    const char *argv[] = {SYSTEMCTL_PATH, machine.c_str(), "--user", "--no-block",
+                          restart ? "restart" : "start", NOTIFICATION_SERVICE, nullptr};
+    const char *envp[] = {nullptr};
+
+    pid_t pid;
+    int ret = posix_spawn(&pid, SYSTEMCTL_PATH, nullptr, nullptr, const_cast<char **>(argv),
+                          const_cast<char **>(envp));
+    if (ret != 0) {
+        ALOGE("Starting notification daemon for user <" << user << "> failed: " << ret);
+        return;
+    }
 
-            ALOGD("Accepted new conection for user: " << user);
-        } catch (...) {
-            Socket::close(fd);
-            throw;
+    ALOGD("Starting notification daemon for user: " << user);
+    m_starters.emplace_back(pid, user);
+}
+
+void NotificationTalker::reapStarters()
+{
+    for (auto it = m_starters.begin(); it != m_starters.end();) {
+        int status;
+        pid_t ret = TEMP_FAILURE_RETRY(waitpid(it->first, &status, WNOHANG));
+        if (ret == 0) {
+            ++it;
+            continue;
         }
+
+        if (ret == -1)
+            ALOGE("Waiting for systemctl of user <" << it->second << "> failed: " << errno);
+        else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+            ALOGE("systemctl could not start notification daemon for user <" << it->second
+                  << ">, exit status: " << WEXITSTATUS(status));
+        else if (WIFSIGNALED(status))
+            ALOGE("systemctl starting notification daemon for user <" << it->second
+                  << "> killed by signal: " << WTERMSIG(status));
+        it = m_starters.erase(it);
+    }
+}
+
+void NotificationTalker::checkHeartbeats()
+{
+    auto now = std::chrono::steady_clock::now();
+    m_nextHeartbeat = std::chrono::steady_clock::time_point::max();
+
+    for (auto &conn : m_connections) {
+        // Idle daemon is not asked, it is checked once it gets request
+        if (conn.fd == -1 || conn.inFlight == 0)
+            continue;
+
+        if (conn.pingSent) {
+            if (now - conn.pinged >= m_heartbeat.deadline) {
+                evict(conn.fd);
+                continue;
+            }
+            m_nextHeartbeat = std::min(m_nextHeartbeat, conn.pinged + m_heartbeat.deadline);
+        } else if (now - conn.heard >= m_heartbeat.interval) {
+            int fd = conn.fd;
+            sendPing(fd);
+            if (!connection(fd))
+                continue;
+            conn.pingSent = true;
+            conn.pinged = now;
+            m_nextHeartbeat = std::min(m_nextHeartbeat, now + m_heartbeat.deadline);
+        } else {
+            m_nextHeartbeat = std::min(m_nextHeartbeat, conn.heard + m_heartbeat.interval);
+        }
+    }
+}
+
+void NotificationTalker::evict(int fd)
+{
+    Connection &conn = m_connections[fd];
+    auto user = conn.user;
+    UserQueue &queue = user->second;
+    ALOGE("Notification daemon of user: " << user->first << " does not respond, dropping it");
+
+    // The oldest request could be the one daemon got stuck on, it times out instead of going
+    // to the next daemon. Other requests are sent again when connection is removed.
+    for (auto it = queue.inFlight.begin(); it != queue.inFlight.end(); ++it) {
+        auto indexIt = m_requestIndex.find(it->id);
+        if (indexIt->second.fd != fd)
+            continue;
+
+        RequestId id = it->id;
+        m_requestIndex.erase(indexIt);
+        queue.inFlight.erase(it);
+        --conn.inFlight;
+        m_responseHandler({id, NResponseType::None});
+        break;
+    }
+
+    // Daemon is still running, it is replaced when user's requests need new one
+    queue.restart = true;
+    remove(fd);
+}
+
+int NotificationTalker::waitTimeout()
+{
+    using std::chrono::milliseconds;
+    int timeout = m_activations ? ACTIVATION_RETRY_MS : -1;
+    // Exit status of systemctl is logged soon after it ends
+    if (!m_starters.empty())
+        timeout = STARTER_CHECK_MS;
+
+    if (m_nextHeartbeat != std::chrono::steady_clock::time_point::max()) {
+        auto left = m_nextHeartbeat - std::chrono::steady_clock::now();
+        // Rounded up, so deadline has passed when loop wakes up
+        int heartbeat = std::max<milliseconds::rep>(
+                std::chrono::duration_cast<milliseconds>(left + milliseconds(1)).count(), 0);
+        timeout = timeout == -1 ? heartbeat : std::min(timeout, heartbeat);
+    }
+
+    return timeout;
+}
+
+std::string NotificationTalker::connectionUser(int fd)
+{
+    char *user_c = nullptr;
+
+    int ret = cynara_creds_socket_get_user(fd, USER_METHOD_DEFAULT,&user_c);
+
+    std::unique_ptr<char[]> userPtr(user_c);
+
+    if (ret != CYNARA_API_SUCCESS) {
+        throw CynaraException("cynara_creds_socket_get_user", ret);
     }
+    return user_c;
 }
 
 void NotificationTalker::remove(int fd)
 {
+    Connection &conn = m_connections[fd];
+    m_poller.remove(fd);
+    if (conn.bell != -1) {
+        m_poller.remove(conn.bell);
+        m_bells.erase(conn.bell);
+    }
     Socket::close(fd);
-    auto user = m_fdToUser[fd];
-    m_fdToUser.erase(fd);
-    m_userToFd.erase(user);
-    m_fdStatus.erase(fd);
+
+    auto user = conn.user;
+    UserQueue &queue = user->second;
+    queue.connections.erase(std::find(queue.connections.begin(), queue.connections.end(), fd));
+
+    // Unanswered requests go back to the front, in order they were sent
+    UserRequests unanswered;
+    for (auto it = queue.inFlight.begin(); it != queue.inFlight.end();) {
+        auto requestIt = it++;
+        auto &location = m_requestIndex[requestIt->id];
+        if (location.fd == fd) {
+            location.fd = -1;
+            unanswered.splice(unanswered.end(), queue.inFlight, requestIt);
+        }
+    }
+    queue.requests.splice(queue.requests.begin(), unanswered);
+    conn = Connection();
+
+    // Other notification daemons of the user take them over
+    sendNext(user);
 }
 
-void NotificationTalker::run()
+void NotificationTalker::handleEvents(int fd, uint32_t events)
 {
+    auto bellIt = m_bells.find(fd);
+    if (bellIt != m_bells.end())
+        fd = bellIt->second;
+
+    // Connection could be dropped while handling earlier event
+    if (!connection(fd))
+        return;
+
+    // Daemon of one user must not break the loop serving all of them
     try {
-        ALOGD("Notification loop started");
-        while (!m_stopflag) {
-            std::lock_guard<std::mutex> lock(m_bfLock);
+        if (bellIt != m_bells.end())
+            handleBell(fd);
+        else
+            handleConnectionEvents(fd, events);
+    } catch (const Exception &e) {
+        ALOGE("Dropping notification daemon connection: " << e.what());
+        if (connection(fd))
+            remove(fd);
+    }
+}
 
-            m_select.add(m_sockfd);
+void NotificationTalker::handleConnectionEvents(int fd, uint32_t events)
+{
+    if (events & Socket::Poller::Write)
+        flush(m_connections[fd]);
 
-            for (auto pair : m_userToFd)
-                m_select.add(std::get<1>(pair));
+    if (connection(fd) && (events & (Socket::Poller::Read | Socket::Poller::Hangup)))
+        recvResponse(fd);
+}
 
-            m_select.setTimeout(100);
-            int rv = m_select.exec();
+void NotificationTalker::handleBell(int fd)
+{
+    // Daemon either wrote responses or made room for requests
+    Connection &conn = m_connections[fd];
+    conn.channel.clearBell();
+    conn.heard = std::chrono::steady_clock::now();
+    conn.pingSent = false;
+
+    flush(conn);
+    if (connection(fd))
+        takeResponses(fd);
+}
+
+void NotificationTalker::run()
+{
+    try {
+        ALOGD("Notification loop started");
+        while (!m_stopflag) {
+            // Agent commands and stop() wake the loop through eventfd
+            int rv = m_poller.wait(waitTimeout());
 
             if (m_stopflag) {
                 clear();
                 break;
             }
 
-            if (rv) {
-                newConnection(rv);
-                recvResponses(rv);
+            for (int i = 0; i < rv; ++i) {
+                // Descriptor closed while handling this batch, its number could be reused
+                int fd = m_poller.fd(i);
+                if (fd == -1)
+                    continue;
+                if (fd == m_eventFd)
+                    runCommands();
+                else if (fd == m_sockfd)
+                    newConnection();
+                else
+                    handleEvents(fd, m_poller.events(i));
             }
 
-            for (auto pair : m_fdStatus ) {
-                int fd = std::get<0>(pair);
-                bool b = std::get<1>(pair);
-                auto &queue = m_requests[m_fdToUser[fd]];
-                if (b && !queue.empty()) {
-                    NotificationRequest request = queue.front();
-                    sendRequest(fd, request);
-                }
-            }
+            if (!m_starters.empty())
+                reapStarters();
+            if (m_activations)
+                retryActivations();
+            if (std::chrono::steady_clock::now() >= m_nextHeartbeat)
+                checkHeartbeats();
         }
         ALOGD("NotificationTalker loop ended");
     } catch (const std::exception &e) {
@@ -316,10 +782,23 @@ void NotificationTalker::run()
     }
 
     if (m_failed && m_responseHandler) {
+        std::vector<TalkerCommand> commands;
+        TalkerCommand command;
+        while (m_commands.pop(command))
+            commands.push_back(std::move(command));
+        for (auto &overflowed : takeOverflow())
+            commands.push_back(std::move(overflowed));
+
+        for (auto &pending : commands) {
+            if (pending.type == RequestType::RT_Action)
+                m_requests[pending.request.data.user].requests.push_back(
+                        std::move(pending.request));
+        }
         for (auto &queuePair : m_requests) {
-            for (auto &request : std::get<1>(queuePair)) {
+            for (auto &request : queuePair.second.inFlight)
+                m_responseHandler({request.id, NResponseType::Error});
+            for (auto &request : queuePair.second.requests)
                 m_responseHandler({request.id, NResponseType::Error});
-            }
         }
     }
 }
@@ -21,18 +21,29 @@
 
 #pragma once
 
+#include <atomic>
 #include <cerrno>
-#include <deque>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <list>
 #include <map>
 #include <mutex>
 #include <string>
 #include <thread>
-
-#include <socket/SelectRead.h>
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <socket/FramedConnection.h>
+#include <socket/Poller.h>
+#include <socket/Socket.h>
 #include <types/RequestId.h>
 #include <types/NotificationResponse.h>
 #include <types/NotificationRequest.h>
+#include <util/CommandRing.h>
 
 #include <main/Request.h>
 
@@ -40,19 +51,77 @@ namespace AskUser {
 
 namespace Agent {
 
-typedef std::pair<std::string, int> UserToFdPair;
-typedef std::map<std::string, int> UserToFdMap;
-typedef std::map<int, std::string> FdToUserMap;
-typedef std::map<int, bool> FdStatus;
-
-typedef std::map<std::string, std::deque<NotificationRequest>> RequestsQueue;
+typedef std::list<NotificationRequest> UserRequests;
+
+struct UserQueue {
+    // Waiting to be sent
+    UserRequests requests;
+    // Sent to one of notification daemons, at most Protocol::requestWindow per connection
+    UserRequests inFlight;
+    // Connections of user's notification daemons, each one gets requests
+    std::vector<int> connections;
+    // Notification daemon was started on demand and did not connect yet
+    bool activating = false;
+    std::chrono::steady_clock::time_point activated;
+    // Daemon stopped responding, so it has to be restarted, not only started
+    bool restart = false;
+};
+typedef std::map<std::string, UserQueue> RequestsQueue;
+
+// State of notification daemon connection, kept in table indexed by descriptor
+struct Connection {
+    int fd = -1;
+    RequestsQueue::iterator user;
+    // Number of user's requests sent through this connection and not answered yet
+    std::size_t inFlight = 0;
+    // Liveness of notification daemon, checked while it has requests to answer
+    std::chrono::steady_clock::time_point heard;
+    std::chrono::steady_clock::time_point pinged;
+    bool pingSent = false;
+    // Output not accepted by socket yet is flushed when descriptor becomes writable
+    Socket::FramedConnection channel;
+    bool writing = false;
+    // Bell of shared rings, if daemon offered them, wakes loop like socket does
+    int bell = -1;
+};
+typedef std::vector<Connection> ConnectionTable;
+
+// Where request waits, so it can be found without searching users queues
+struct RequestLocation {
+    RequestsQueue::iterator user;
+    UserRequests::iterator request;
+    // Connection which request was sent through, -1 while it waits to be sent
+    int fd;
+};
+typedef std::unordered_map<RequestId, RequestLocation> RequestIndex;
 
 typedef std::function<void(NotificationResponse)> ResponseHandler;
 
+// Notification daemon silent for interval is pinged, one not answering within deadline is dropped
+struct Heartbeat {
+    Heartbeat(std::chrono::milliseconds interval_ = std::chrono::seconds(5),
+              std::chrono::milliseconds deadline_ = std::chrono::seconds(3))
+        : interval(interval_), deadline(deadline_) {}
+
+    std::chrono::milliseconds interval;
+    std::chrono::milliseconds deadline;
+};
+
+// Request passed from agent thread to talker thread
+struct TalkerCommand {
+    TalkerCommand() : type(RequestType::RT_Action), request(0) {}
+    TalkerCommand(RequestType type_, NotificationRequest &&request_)
+        : type(type_), request(std::move(request_)) {}
+
+    RequestType type;
+    NotificationRequest request;
+};
+
 class NotificationTalker
 {
 public:
-    NotificationTalker();
+    NotificationTalker(Heartbeat heartbeat = Heartbeat(),
+                       Socket::Type socketType = Socket::Type::Stream);
     bool isFailed() { return m_failed; }
     std::string getErrorMsg() { return m_errorMsg; }
     void setResponseHandler(ResponseHandler responseHandler)
@@ -66,35 +135,73 @@ public:
 
 protected:
     void setErrorMsg(std::string s);
+    void wakeUp();
+    void runCommands();
+    void runCommand(TalkerCommand &command);
+    std::vector<TalkerCommand> takeOverflow();
     void run();
     void parseResponse(NotificationResponse response, int fd);
-    void recvResponses(int &rv);
-
-    void newConnection(int &rv);
+    void recvResponse(int fd);
+    void takeResponses(int fd);
+    void handleEvents(int fd, uint32_t events);
+    void handleConnectionEvents(int fd, uint32_t events);
+    void handleBell(int fd);
+
+    void newConnection();
+    virtual std::string connectionUser(int fd);
     void remove(int fd);
+    Connection *connection(int fd);
+    void sendNext(RequestsQueue::iterator user);
+    void activate(RequestsQueue::iterator user);
+    void retryActivations();
+    void checkHeartbeats();
+    void evict(int fd);
+    int waitTimeout();
+    virtual void startDaemon(const std::string &user, bool restart);
+    void reapStarters();
+    void sendMessage(Connection &conn, const void *head, std::size_t headSize,
+                     const void *body = nullptr, std::size_t bodySize = 0);
+    void flush(Connection &conn);
+    void watchOutput(Connection &conn);
 
     void clear();
 
     virtual void addRequest(NotificationRequest &&request);
     virtual void removeRequest(RequestId id);
-    virtual void sendRequest(int fd, const NotificationRequest &request);
-    virtual void sendDismiss(int fd);
+    virtual void sendRequests(int fd, const std::vector<NotificationRequest> &requests);
+    virtual void sendDismiss(int fd, RequestId id);
+    void sendAck(int fd, RequestId id);
+    void sendPing(int fd);
 
     ResponseHandler m_responseHandler;
 
-    UserToFdMap m_userToFd;
-    FdToUserMap m_fdToUser;
-    FdStatus m_fdStatus;
-    Socket::SelectRead m_select;
-    int m_sockfd = 0;
+    ConnectionTable m_connections;
+    // Shared ring bells and connections they belong to
+    std::unordered_map<int, int> m_bells;
+    Socket::Poller m_poller;
+    int m_sockfd = -1;
+    int m_eventFd = -1;
     bool m_failed;
     std::string m_errorMsg;
 
     RequestsQueue m_requests;
-    std::mutex m_bfLock;
+    RequestIndex m_requestIndex;
+    std::size_t m_activations = 0;
+    // systemctl processes starting notification daemons and users they start them for
+    std::vector<std::pair<pid_t, std::string>> m_starters;
+    Heartbeat m_heartbeat;
+    // Earliest time some connection has to be pinged or its ping deadline passes
+    std::chrono::steady_clock::time_point m_nextHeartbeat;
+
+    // Talker thread owns all above, agent only pushes commands and wakes it up
+    Util::CommandRing<TalkerCommand> m_commands;
+    // Commands which did not fit into full ring, kept in order until talker takes them
+    std::mutex m_overflowLock;
+    std::vector<TalkerCommand> m_overflow;
+    std::atomic<bool> m_overflowing;
 
     std::thread m_thread;
-    bool m_stopflag;
+    std::atomic<bool> m_stopflag;
 };
 
 } /* namespace Agent */
@@ -21,19 +21,22 @@
 
 #include "AskUserTalker.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <unistd.h>
 
+#include <socket/FramedConnection.h>
 #include <socket/Socket.h>
-#include <socket/SelectRead.h>
 #include <types/NotificationResponse.h>
 #include <types/Protocol.h>
 #include <types/NotificationRequest.h>
-#include <exception/ErrnoException.h>
 #include <exception/Exception.h>
 #include <translator/Translator.h>
 #include <config/Path.h>
-#include <config/Limits.h>
+#include <label/Label.h>
 
 #include <security-manager.h>
 
@@ -49,13 +52,6 @@ inline void throwOnSecurityPrivilegeError(std::string err, int ret)
         throw Exception(err + " : " + std::to_string(ret));
 }
 
-inline const char *dropPrefix(const char* app)
-{
-    constexpr char prefix[] = "User::App::";
-    constexpr size_t prefixSize = sizeof(prefix) - 1;
-    return strncmp(app, prefix, prefixSize) ? app : app + prefixSize;
-}
-
 void setSecurityLevel(const std::string &app, const std::string &perm, const std::string &level)
 {
     int ret;
@@ -76,7 +72,7 @@ void setSecurityLevel(const std::string &app, const std::string &perm, const std
         throwOnSecurityPrivilegeError("security_manager_policy_entry_new", ret);
 
         ret = security_manager_policy_entry_set_application(policyEntry,
-                                                        dropPrefix(app.c_str()));
+                                                        Label::appId(app).c_str());
         throwOnSecurityPrivilegeError("security_manager_policy_entry_set_application", ret);
 
         ret = security_manager_policy_entry_set_privilege(policyEntry, perm.c_str());
@@ -103,8 +99,8 @@ void setSecurityLevel(const std::string &app, const std::string &perm, const std
 } /* namespace */
 
 
-AskUserTalker::AskUserTalker(GuiRunner *gui) : m_gui(gui) {
-    m_gui->setDropHandler([&](){return this->shouldDismiss();});
+AskUserTalker::AskUserTalker(GuiRunner *gui, std::chrono::seconds idleTimeout, bool sharedRing)
+    : m_gui(gui), m_idleTimeout(idleTimeout), m_sharedRing(sharedRing) {
 }
 
 AskUserTalker::~AskUserTalker()
@@ -120,87 +116,311 @@ AskUserTalker::~AskUserTalker()
 
 void AskUserTalker::run()
 {
-    sockfd = Socket::connect(Path::getSocketPath());
+    // Askuserd pings daemon as soon as it has requests, busy initializing EFL it would be dropped
+    m_gui->initialize();
+
+    sockfd = Socket::connect(Path::getSocketPath(), Socket::Type::SeqPacket);
+    // Loop is woken when input comes, reading must not block it afterwards
+    Socket::setNonBlocking(sockfd);
+    m_connection = Socket::FramedConnection(sockfd);
+    if (m_sharedRing && !m_connection.offerRing()) {
+        ALOGI("Askuserd closed connection, closing...");
+        return;
+    }
 
-    while (!stopFlag) {
-        size_t size;
-        char *buf;
-        NotificationResponse response;
+    // Socket tells about end of connection even when frames come through shared ring
+    m_gui->watchInput(sockfd, [this]() {
+        return m_connection.receive() && handleInput();
+    });
+    m_gui->watchOutput(sockfd, [this]() {
+        return flushOutput();
+    });
+    // Bell rings for room in ring as well, responses waiting for it are flushed then
+    if (m_connection.bell() != -1) {
+        m_gui->watchInput(m_connection.bell(), [this]() {
+            m_connection.clearBell();
+            return flushOutput() && handleInput();
+        });
+    }
 
-        ALOGD("Waiting for request...");
+    ALOGD("Waiting for request...");
+    updateIdleTimer();
+    m_gui->run();
+}
 
-        if (!Socket::recv(sockfd, &size, sizeof(size))) {
+bool AskUserTalker::handleInput()
+{
+    Socket::Frame frame;
+    while (m_connection.nextFrame(frame)) {
+        if (!handleMessage(frame)) {
             ALOGI("Askuserd closed connection, closing...");
-            break;
+            return false;
         }
+    }
 
-        Limits::checkSizeLimit(size);
+    showNext();
+    updateIdleTimer();
+    return true;
+}
 
-        buf = new char[size];
+bool AskUserTalker::handleMessage(const Socket::Frame &frame)
+{
+    if (frame.size < sizeof(uint8_t))
+        throw Exception("Empty message");
+
+    uint8_t code = frame.data[0];
+    const char *data = frame.data + sizeof(code);
+    std::size_t size = frame.size - sizeof(code);
+
+    RequestId id;
+    switch (code) {
+    case Protocol::requestCode: {
+        // Decoded right from the frame, requests live in their group until it is done with
+        RequestGroup group = spareGroup();
+        Translator::Gui::dataToNotificationRequests(data, size, group);
+        queue(std::move(group));
+        return true;
+    }
+    case Protocol::dissmisCode:
+    case Protocol::ackCode:
+        if (size != sizeof(id))
+            throw Exception("Incorrect message size");
+        memcpy(&id, data, sizeof(id));
+        if (code == Protocol::dissmisCode)
+            dismiss(id);
+        else
+            acknowledge(id);
+        return true;
+    case Protocol::pingCode: {
+        // Answered while popup is shown as well, askuserd drops daemons which do not answer
+        NotificationResponse pong = {0, NResponseType::Pong};
+        return sendResponse(pong);
+    }
+    default:
+        throw Exception("Incorrect message code");
+    }
+}
 
-        if (!Socket::recv(sockfd, buf, size)) {
-            ALOGI("Askuserd closed connection, closing...");
-            break;
-        }
+bool AskUserTalker::sendResponse(const NotificationResponse &response)
+{
+    if (!m_connection.send(&response, sizeof(response)))
+        return false;
+
+    // What socket did not take is flushed by loop, popup stays responsive meanwhile
+    m_gui->setOutputWatched(sockfd, m_connection.socketOutputPending());
+    return true;
+}
+
+bool AskUserTalker::flushOutput()
+{
+    bool pending = m_connection.outputPending();
+    if (!m_connection.flush()) {
+        ALOGI("Askuserd closed connection, closing...");
+        return false;
+    }
+
+    m_gui->setOutputWatched(sockfd, m_connection.socketOutputPending());
+    // Idle timer waits for responses to leave, daemon may quit once they did
+    if (pending && !m_connection.outputPending())
+        updateIdleTimer();
+    return true;
+}
 
-        NotificationRequest request = Translator::Gui::dataToNotificationRequest(buf);
-        delete[] buf;
+void AskUserTalker::queue(RequestGroup &&group)
+{
+    if (group.empty()) {
+        recycle(std::move(group));
+        return;
+    }
+
+    // Requests of the client which already waits join its popup
+    for (auto &pending : m_pending) {
+        if (pending.front().data.client != group.front().data.client)
+            continue;
+
+        auto joining = std::min(group.size(), Protocol::requestGroupLimit - pending.size());
+        std::move(group.begin(), group.begin() + joining, std::back_inserter(pending));
+        group.erase(group.begin(), group.begin() + joining);
+        break;
+    }
+
+    if (!group.empty())
+        m_pending.push_back(std::move(group));
+    else
+        recycle(std::move(group));
+}
+
+AskUserTalker::RequestGroup AskUserTalker::spareGroup()
+{
+    if (m_spareGroups.empty())
+        return RequestGroup();
+
+    RequestGroup group = std::move(m_spareGroups.back());
+    m_spareGroups.pop_back();
+    return group;
+}
+
+void AskUserTalker::recycle(RequestGroup &&group)
+{
+    m_spareGroups.push_back(std::move(group));
+}
+
+void AskUserTalker::showNext()
+{
+    if (m_showing || m_pending.empty())
+        return;
+
+    m_current = std::move(m_pending.front());
+    m_pending.erase(m_pending.begin());
+
+    std::vector<std::string> privileges;
+    for (auto &request : m_current) {
         ALOGD("Recieved data " << request.data.client << " " << request.data.privilege);
+        privileges.push_back(request.data.privilege);
+    }
+
+    m_dismissed.assign(m_current.size(), false);
+    m_showing = true;
+
+    auto handler = [this](const std::vector<NResponseType> &responses) {
+        answered(responses);
+    };
+    if (!m_gui->popupShow(m_current.front().data.client, privileges, handler))
+        answered(std::vector<NResponseType>(m_current.size(), NResponseType::Error));
+}
 
-        response.response = m_gui->popupRun(request.data.client, request.data.privilege);
-        response.id = request.id;
+void AskUserTalker::answered(const std::vector<NResponseType> &responses)
+{
+    m_showing = false;
 
-        if (response.response == NResponseType::None) {
+    bool failed = false;
+    for (std::size_t i = 0; i < m_current.size(); ++i) {
+        if (responses[i] == NResponseType::None || m_dismissed[i])
             continue;
-        }
 
-        if (!Socket::send(sockfd, &response, sizeof(response))) {
+        NotificationResponse response = {m_current[i].id, responses[i]};
+        if (!sendResponse(response)) {
             ALOGI("Askuserd closed connection, closing...");
-            break;
+            m_gui->quit();
+            return;
         }
 
-        uint8_t ack = 0x00;
-        if (!Socket::recv(sockfd, &ack, sizeof(ack))) {
-            ALOGI("Askuserd closed connection, closing...");
-            break;
+        if (response.response == NResponseType::Error) {
+            failed = true;
+            continue;
         }
 
-        if (ack != Protocol::ackCode)
-            throw Exception("Incorrect ack");
-
-        switch (response.response) {
-        case NResponseType::Error:
-            throw Exception(m_gui->getErrorMsg());
-        case NResponseType::Allow:
-        case NResponseType::Never:
-            setSecurityLevel(request.data.client, request.data.privilege,
-                             Translator::Gui::responseToString(response.response));
-        default:
-            break;
-        }
+        remember(m_current[i], response.response);
     }
+    recycle(std::move(m_current));
+
+    if (failed)
+        throw Exception(m_gui->getErrorMsg());
+
+    showNext();
+    updateIdleTimer();
 }
 
-void AskUserTalker::stop()
+void AskUserTalker::updateIdleTimer()
 {
-    m_gui->stop();
-    Socket::close(sockfd);
+    // Acknowledgments are waited for, as security level is set when they come
+    bool idle = !m_showing && m_pending.empty() && !m_connection.outputPending()
+                && std::none_of(m_answered.begin(), m_answered.end(),
+                                [](const Answer &answer) { return answer.waiting; });
+    if (m_idleTimeout.count() <= 0 || !idle) {
+        m_gui->stopTimer();
+        return;
+    }
+
+    m_gui->startTimer(m_idleTimeout, [this]() {
+        ALOGI("No request for " << m_idleTimeout.count() << " s, closing...");
+        m_gui->quit();
+    });
 }
 
-bool AskUserTalker::shouldDismiss()
+void AskUserTalker::dismiss(RequestId id)
 {
-    Socket::SelectRead select;
-    select.add(sockfd);
-    if (select.exec() == 0)
-        return false;
+    if (m_showing) {
+        for (std::size_t i = 0; i < m_current.size(); ++i) {
+            if (m_current[i].id == id)
+                m_dismissed[i] = true;
+        }
+        // Popup is closed only when none of its requests waits for answer
+        if (std::find(m_dismissed.begin(), m_dismissed.end(), false) == m_dismissed.end()) {
+            m_gui->popupClose();
+            m_showing = false;
+            recycle(std::move(m_current));
+        }
+    }
 
-    uint8_t a = 0x00;
-    Socket::recv(sockfd, &a, sizeof(a));
+    for (auto groupIt = m_pending.begin(); groupIt != m_pending.end(); ++groupIt) {
+        auto it = std::find_if(groupIt->begin(), groupIt->end(),
+                               [id](const NotificationRequest &request) {
+                                   return request.id == id;
+                               });
+        if (it == groupIt->end())
+            continue;
 
-    if (a != Protocol::dissmisCode)
-        throw Exception("Incorrect dismiss flag");
+        groupIt->erase(it);
+        if (groupIt->empty()) {
+            recycle(std::move(*groupIt));
+            m_pending.erase(groupIt);
+        }
+        break;
+    }
 
-    return true;
+    Answer *answer = findAnswer(id);
+    if (answer)
+        answer->waiting = false;
+}
+
+void AskUserTalker::acknowledge(RequestId id)
+{
+    Answer *answer = findAnswer(id);
+    if (!answer)
+        return;
+
+    answer->waiting = false;
+    switch (answer->response) {
+    case NResponseType::Allow:
+    case NResponseType::Never:
+        setSecurityLevel(answer->request.data.client, answer->request.data.privilege,
+                         Translator::Gui::responseToString(answer->response));
+        break;
+    case NResponseType::AllowTimed:
+        // Temporary grant lives in cynara plugins only, security level stays as it was
+    default:
+        break;
+    }
+}
+
+void AskUserTalker::remember(const NotificationRequest &request, NResponseType response)
+{
+    // Copying into free slot reuses its strings
+    for (auto &answer : m_answered) {
+        if (!answer.waiting) {
+            answer.request = request;
+            answer.response = response;
+            answer.waiting = true;
+            return;
+        }
+    }
+    m_answered.push_back(Answer{request, response, true});
+}
+
+AskUserTalker::Answer *AskUserTalker::findAnswer(RequestId id)
+{
+    for (auto &answer : m_answered) {
+        if (answer.waiting && answer.request.id == id)
+            return &answer;
+    }
+    return nullptr;
+}
+
+void AskUserTalker::stop()
+{
+    m_gui->stop();
+    Socket::close(sockfd);
 }
 
 } /* namespace Notification */
@@ -21,10 +21,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <queue>
 #include <memory>
 #include <mutex>
+#include <vector>
+
+#include <socket/FramedConnection.h>
+#include <types/NotificationRequest.h>
+#include <types/NotificationResponse.h>
 
 #include "GuiRunner.h"
 
@@ -35,18 +41,56 @@ namespace Notification {
 class AskUserTalker
 {
 public:
-      AskUserTalker(GuiRunner *gui);
+      // Zero idle timeout keeps daemon running, otherwise it exits when nothing is asked for so long
+      AskUserTalker(GuiRunner *gui, std::chrono::seconds idleTimeout = std::chrono::seconds(0),
+                    bool sharedRing = false);
       ~AskUserTalker();
 
       void run();
       void stop();
 
-      bool shouldDismiss();
-
 private:
+      struct Answer {
+          NotificationRequest request;
+          NResponseType response;
+          // Slot is reused for next answer once this one is acknowledged or dismissed
+          bool waiting;
+      };
+
+      bool handleInput();
+      bool handleMessage(const Socket::Frame &frame);
+      bool sendResponse(const NotificationResponse &response);
+      bool flushOutput();
+      void showNext();
+      void answered(const std::vector<NResponseType> &responses);
+      void updateIdleTimer();
+      void dismiss(RequestId id);
+      void acknowledge(RequestId id);
+      void remember(const NotificationRequest &request, NResponseType response);
+      Answer *findAnswer(RequestId id);
+
       GuiRunner *m_gui;
+      std::chrono::seconds m_idleTimeout;
+      // Messages go through shared memory rings instead of socket, once askuserd accepts them
+      bool m_sharedRing;
       int sockfd = 0;
-      bool stopFlag = false;
+      Socket::FramedConnection m_connection;
+
+      typedef std::vector<NotificationRequest> RequestGroup;
+
+      void queue(RequestGroup &&group);
+      RequestGroup spareGroup();
+      void recycle(RequestGroup &&group);
+
+      // Received while other popup was shown, each group of one client gets one popup
+      std::vector<RequestGroup> m_pending;
+      RequestGroup m_current;
+      std::vector<bool> m_dismissed;
+      bool m_showing = false;
+      // Groups done with, requests are decoded into their strings, so they do not allocate
+      std::vector<RequestGroup> m_spareGroups;
+      // Sent to askuserd, security level is set when askuserd acknowledges answer
+      std::vector<Answer> m_answered;
 };
 
 } /* namespace Notification */
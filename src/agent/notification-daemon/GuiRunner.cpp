@@ -24,6 +24,7 @@
 #include <exception/ErrnoException.h>
 #include <exception/Exception.h>
 #include <translator/Translator.h>
+#include <types/TimedPolicy.h>
 #include <libintl.h>
 #include <privilegemgr/privilege_info.h>
 
@@ -42,10 +43,9 @@ void unfocused(void *data, Evas_Object *, void *)
 
     PopupData *res = static_cast<PopupData*>(data);
 
+    // Answered popup is lowered, it is not raised again
     if (should_raise)
         elm_win_raise(res->win);
-    else
-        elm_exit();
 }
 
 void inline win_close(Evas_Object *win) {
@@ -63,11 +63,16 @@ void inline answer(void *data, NResponseType response)
     PopupData *res = static_cast<PopupData*>(data);
     res->type = response;
     win_close(res->win);
+    res->answered();
 }
 
 void allow_answer(void *data, Evas_Object *, void *)
 {
-    answer(data, NResponseType::Allow);
+    PopupData *res = static_cast<PopupData*>(data);
+    if (res && res->timedCheck && elm_check_state_get(res->timedCheck))
+        answer(data, NResponseType::AllowTimed);
+    else
+        answer(data, NResponseType::Allow);
 }
 
 void deny_answer(void *data, Evas_Object *, void *)
@@ -80,19 +85,6 @@ void never_answer(void *data, Evas_Object *, void *)
     answer(data, NResponseType::Never);
 }
 
-Eina_Bool timeout_answer(void *data) {
-    if (!data)
-        return ECORE_CALLBACK_RENEW;
-
-    drop *d = static_cast<drop*>(data);
-
-    if (d->handle()) {
-        win_close(d->popup->win);
-    }
-
-    return ECORE_CALLBACK_RENEW;
-}
-
 std::string friendlyPrivilegeName(const std::string &privilege)
 {
     char *name = nullptr;
@@ -108,9 +100,10 @@ std::string friendlyPrivilegeName(const std::string &privilege)
 
 } /* namespace */
 
-GuiRunner::GuiRunner()
+GuiRunner::GuiRunner() : m_started(std::chrono::steady_clock::now())
 {
-    m_popupData = new PopupData({NResponseType::Deny, nullptr});
+    m_popupData = new PopupData({NResponseType::Deny, nullptr, nullptr,
+                                 [this]() { popupAnswered(); }});
 }
 
 GuiRunner::~GuiRunner()
@@ -118,9 +111,135 @@ GuiRunner::~GuiRunner()
     delete m_popupData;
 }
 
-void GuiRunner::initialize()
+void GuiRunner::startLoop()
 {
+    if (m_loopStarted)
+        return;
+
     elm_init(0, NULL);
+    m_loopStarted = true;
+}
+
+void GuiRunner::run()
+{
+    startLoop();
+    m_failed = false;
+    elm_run();
+
+    for (auto &watch : m_watches) {
+        if (watch->fdHandler)
+            ecore_main_fd_handler_del(watch->fdHandler);
+    }
+    m_watches.clear();
+    stopTimer();
+
+    if (m_failed)
+        throw Exception(m_loopError);
+}
+
+void GuiRunner::quit()
+{
+    elm_exit();
+}
+
+void GuiRunner::dispatch(const InputHandler &handler)
+{
+    // Exceptions must not go through ecore, they are thrown again when loop ends
+    try {
+        if (handler())
+            return;
+    } catch (const std::exception &e) {
+        m_loopError = e.what();
+        m_failed = true;
+    } catch (...) {
+        m_loopError = "unknown error";
+        m_failed = true;
+    }
+    quit();
+}
+
+Eina_Bool GuiRunner::fdReady(void *data, Ecore_Fd_Handler *fdHandler)
+{
+    Watch *watch = static_cast<Watch *>(data);
+    bool output = ecore_main_fd_handler_active_get(fdHandler, ECORE_FD_WRITE);
+    if (output)
+        watch->runner->dispatch(watch->outputHandler);
+    // End of connection comes as input as well
+    if (!output || ecore_main_fd_handler_active_get(fdHandler, ECORE_FD_READ))
+        watch->runner->dispatch(watch->handler);
+    return ECORE_CALLBACK_RENEW;
+}
+
+Eina_Bool GuiRunner::timerExpired(void *data)
+{
+    GuiRunner *runner = static_cast<GuiRunner *>(data);
+    runner->m_timer = nullptr;
+    TimerHandler handler = std::move(runner->m_timerHandler);
+    runner->dispatch([&handler]() {
+        handler();
+        return true;
+    });
+    return ECORE_CALLBACK_CANCEL;
+}
+
+void GuiRunner::watchInput(int fd, InputHandler handler)
+{
+    startLoop();
+    std::unique_ptr<Watch> watch(new Watch({this, fd, std::move(handler), nullptr, nullptr}));
+    watch->fdHandler = ecore_main_fd_handler_add(fd, ECORE_FD_READ, fdReady, watch.get(),
+                                                 nullptr, nullptr);
+    if (!watch->fdHandler)
+        throw Exception("Adding descriptor to ecore loop failed");
+    m_watches.push_back(std::move(watch));
+}
+
+GuiRunner::Watch &GuiRunner::findWatch(int fd)
+{
+    for (auto &watch : m_watches) {
+        if (watch->fd == fd)
+            return *watch;
+    }
+    throw Exception("Descriptor " + std::to_string(fd) + " is not watched");
+}
+
+void GuiRunner::watchOutput(int fd, InputHandler handler)
+{
+    findWatch(fd).outputHandler = std::move(handler);
+}
+
+void GuiRunner::setOutputWatched(int fd, bool watched)
+{
+    Watch &watch = findWatch(fd);
+    int flags = ECORE_FD_READ | (watched ? ECORE_FD_WRITE : 0);
+    ecore_main_fd_handler_active_set(watch.fdHandler, static_cast<Ecore_Fd_Handler_Flags>(flags));
+}
+
+void GuiRunner::startTimer(std::chrono::seconds timeout, TimerHandler handler)
+{
+    startLoop();
+    stopTimer();
+    m_timerHandler = std::move(handler);
+    m_timer = ecore_timer_add(timeout.count(), timerExpired, this);
+    if (!m_timer)
+        throw Exception("Adding timer to ecore loop failed");
+}
+
+void GuiRunner::stopTimer()
+{
+    if (m_timer) {
+        ecore_timer_del(m_timer);
+        m_timer = nullptr;
+    }
+    m_timerHandler = nullptr;
+}
+
+void GuiRunner::initialize()
+{
+    if (m_initialized)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    startLoop();
 
     //placeholder
     m_win = elm_win_add(NULL, dgettext(PROJECT_NAME, "SID_PRIVILEGE_REQUEST_DIALOG_TITLE"),
@@ -148,6 +267,18 @@ void GuiRunner::initialize()
 
     evas_object_show(m_content);
     elm_box_pack_end(m_box, m_content);
+
+    // limits "allow" to TimedPolicy::AllowDuration
+    char *timedFormat = dgettext(PROJECT_NAME, "SID_PRIVILEGE_REQUEST_DIALOG_CHECK_TIMED");
+    char timedText[BUFSIZ];
+    std::snprintf(timedText, sizeof(timedText), timedFormat,
+                  static_cast<int>(TimedPolicy::AllowDuration.count()));
+
+    m_timedCheck = elm_check_add(m_popup);
+    elm_object_text_set(m_timedCheck, timedText);
+    evas_object_size_hint_align_set(m_timedCheck, 0.0, EVAS_HINT_FILL);
+    evas_object_show(m_timedCheck);
+    elm_box_pack_end(m_box, m_timedCheck);
     elm_object_part_content_set(m_popup, "default", m_box);
 
     // buttons
@@ -173,70 +304,138 @@ void GuiRunner::initialize()
     evas_object_smart_callback_add(m_denyButton, "clicked", deny_answer, m_popupData);
 
     m_popupData->win = m_win;
+    m_popupData->timedCheck = m_timedCheck;
     m_initialized = true;
 
+    ALOGI("Popup initialized in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now() - start).count()
+          << " ms");
+
 }
 
-NResponseType GuiRunner::popupRun(const std::string &app, const std::string &perm)
+bool GuiRunner::popupShow(const std::string &app, const std::vector<std::string> &privileges,
+                          AnswerHandler handler)
 {
-
     try {
-        if (!m_dropHandler)
-            throw Exception("DropHandler was not initialized");
+        if (privileges.empty())
+            throw Exception("No privileges to ask for");
 
         if (!m_initialized)
             initialize();
 
-        m_running = true;
-        drop *Drop = new drop({m_dropHandler, m_popupData});
-        m_timer = ecore_timer_add(0.1, timeout_answer, Drop);
-
         // create message
-        char *messageFormat = dgettext(PROJECT_NAME, "SID_PRIVILEGE_REQUEST_DIALOG_MESSAGE");
         char buf[BUFSIZ];
-        int ret = std::snprintf(buf, sizeof(buf), messageFormat,
+        int ret;
+        if (privileges.size() == 1) {
+            char *messageFormat = dgettext(PROJECT_NAME, "SID_PRIVILEGE_REQUEST_DIALOG_MESSAGE");
+            ret = std::snprintf(buf, sizeof(buf), messageFormat,
                                 app.c_str(),
-                                friendlyPrivilegeName(perm).c_str());
+                                friendlyPrivilegeName(privileges.front()).c_str());
+        } else {
+            char *messageFormat = dgettext(PROJECT_NAME,
+                                           "SID_PRIVILEGE_REQUEST_DIALOG_MESSAGE_GROUP");
+            ret = std::snprintf(buf, sizeof(buf), messageFormat, app.c_str());
+        }
 
         if (ret < 0)
             throw ErrnoException("snprintf failed", errno);
 
+        // every privilege of group can be unchecked, to allow only some of them
+        if (privileges.size() > 1) {
+            for (auto &privilege : privileges) {
+                Evas_Object *check = elm_check_add(m_popup);
+                elm_object_text_set(check, friendlyPrivilegeName(privilege).c_str());
+                elm_check_state_set(check, EINA_TRUE);
+                evas_object_size_hint_align_set(check, 0.0, EVAS_HINT_FILL);
+                evas_object_show(check);
+                elm_box_pack_before(m_box, check, m_timedCheck);
+                m_privilegeChecks.push_back(check);
+            }
+        }
+
         m_popupData->type = NResponseType::None;
+        m_answerHandler = std::move(handler);
+        m_running = true;
 
         should_raise = true;
 
         elm_object_text_set(m_content, buf);
+        elm_check_state_set(m_timedCheck, EINA_FALSE);
 
         evas_object_show(m_popup);
         evas_object_show(m_win);
 
         elm_win_raise(m_win);
-        elm_run();
-
-        ecore_timer_del(m_timer);
-        m_running = false;
-        should_raise = false;
+        if (!m_shown) {
+            m_shown = true;
+            ALOGI("First popup shown " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             std::chrono::steady_clock::now() - m_started).count()
+                  << " ms after start");
+        }
+        return true;
     } catch (const std::exception &e) {
-        m_popupData->type = NResponseType::Error;
-        m_errorMsg = std::move(e.what());
+        m_errorMsg = e.what();
     }
 
-    return m_popupData->type;
+    clearChecks();
+    return false;
 }
 
-void GuiRunner::setDropHandler(DropHandler dropHandler)
+void GuiRunner::popupAnswered()
 {
-    m_dropHandler = dropHandler;
+    if (!m_running)
+        return;
+
+    NResponseType type = m_popupData->type;
+    bool allowed = type == NResponseType::Allow || type == NResponseType::AllowTimed;
+    std::vector<NResponseType> responses;
+    if (m_privilegeChecks.empty()) {
+        responses.push_back(type);
+    } else {
+        for (auto check : m_privilegeChecks) {
+            responses.push_back(allowed && !elm_check_state_get(check) ? NResponseType::Deny
+                                                                        : type);
+        }
+    }
+
+    // Handler may show next popup right away
+    AnswerHandler handler = std::move(m_answerHandler);
+    m_answerHandler = nullptr;
+    m_running = false;
+    clearChecks();
+    dispatch([&]() {
+        handler(responses);
+        return true;
+    });
+}
+
+void GuiRunner::popupClose()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_answerHandler = nullptr;
+    win_close(m_win);
+    clearChecks();
+}
+
+void GuiRunner::clearChecks()
+{
+    for (auto check : m_privilegeChecks)
+        evas_object_del(check);
+    m_privilegeChecks.clear();
 }
 
 void GuiRunner::stop()
 {
-    if (m_running) {
+    if (m_running)
         evas_object_hide(m_win);
+
+    if (m_loopStarted) {
         elm_exit();
+        elm_shutdown();
     }
-
-    elm_shutdown();
 }
 
 } /* namespace Notification */
@@ -22,8 +22,11 @@
 #pragma once
 
 #include <Elementary.h>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <types/NotificationResponse.h>
 #include <log/alog.h>
@@ -32,49 +35,108 @@ namespace AskUser {
 
 namespace Notification {
 
-typedef std::function<bool()> DropHandler;
+// Returns false when loop should end
+typedef std::function<bool()> InputHandler;
+typedef std::function<void(const std::vector<NResponseType> &)> AnswerHandler;
+typedef std::function<void()> TimerHandler;
 
 struct PopupData {
     NResponseType type;
     Evas_Object *win;
+    Evas_Object *timedCheck;
+    std::function<void()> answered;
 };
 
-struct drop {
-    DropHandler handle;
-    PopupData *popup;
-};
-
+/*
+ * Owns the one ecore loop of the daemon. Descriptors, timer and popup answers are its events,
+ * handlers run inside the loop, so nothing blocks it and idle daemon does not wake up.
+ */
 class GuiRunner {
 public:
     GuiRunner();
     ~GuiRunner();
 
-    NResponseType popupRun(const std::string &app, const std::string &perm);
+    /* Runs loop until quit() or failing handler, whose error is thrown then */
+    void run();
+    void quit();
+
+    /*
+     * Builds popup, which is most of daemon cold start. Loop cannot answer anything meanwhile,
+     * so it is done before connecting to askuserd, otherwise popupShow() does it.
+     */
+    void initialize();
+
+    void watchInput(int fd, InputHandler handler);
+    /*
+     * Handler of input watched fd called when it takes more output, only while output is
+     * watched. Ecore has one handler per descriptor, so both directions share it.
+     */
+    void watchOutput(int fd, InputHandler handler);
+    void setOutputWatched(int fd, bool watched);
+    /* One-shot timer, starting it again replaces the previous one */
+    void startTimer(std::chrono::seconds timeout, TimerHandler handler);
+    void stopTimer();
+
+    /*
+     * Shows one popup for all listed privileges of the app, handler gets answer for each of them.
+     * "Allow" applies to privileges left checked, the other ones are denied once.
+     * Returns false if popup could not be shown, getErrorMsg() tells why.
+     */
+    bool popupShow(const std::string &app, const std::vector<std::string> &privileges,
+                   AnswerHandler handler);
+    /* Closes popup without answer, when its requests are not waited for anymore */
+    void popupClose();
 
-    void setDropHandler(DropHandler dropHandler);
     void stop();
 
     std::string getErrorMsg() { return m_errorMsg; }
 
 private:
+    struct Watch {
+        GuiRunner *runner;
+        int fd;
+        InputHandler handler;
+        InputHandler outputHandler;
+        Ecore_Fd_Handler *fdHandler;
+    };
+
     PopupData *m_popupData;
-    DropHandler m_dropHandler;
+    AnswerHandler m_answerHandler;
 
     Evas_Object *m_win;
     Evas_Object *m_popup;
     Evas_Object *m_box;
     Evas_Object *m_content;
+    Evas_Object *m_timedCheck;
+    std::vector<Evas_Object *> m_privilegeChecks;
     Evas_Object *m_allowButton;
     Evas_Object *m_neverButton;
     Evas_Object *m_denyButton;
-    Ecore_Timer *m_timer;
+
+    std::vector<std::unique_ptr<Watch>> m_watches;
+    Ecore_Timer *m_timer = nullptr;
+    TimerHandler m_timerHandler;
 
     bool m_running = false;
+    bool m_loopStarted = false;
     bool m_initialized = false;
+    bool m_failed = false;
+
+    // Cold start cost, daemon is started when first request comes
+    std::chrono::steady_clock::time_point m_started;
+    bool m_shown = false;
 
     std::string m_errorMsg;
+    std::string m_loopError;
 
-    void initialize();
+    void startLoop();
+    void popupAnswered();
+    void clearChecks();
+    void dispatch(const InputHandler &handler);
+    Watch &findWatch(int fd);
+
+    static Eina_Bool fdReady(void *data, Ecore_Fd_Handler *fdHandler);
+    static Eina_Bool timerExpired(void *data);
 };
 
 } /* namespace Notification */
@@ -19,6 +19,7 @@
  * @brief       Main askuser notification daemon file
  */
 
+#include <chrono>
 #include <clocale>
 #include <csignal>
 #include <cstdlib>
@@ -33,6 +34,25 @@
 #include "GuiRunner.h"
 #include "AskUserTalker.h"
 
+namespace {
+
+// askuserd starts daemon again when it is needed
+const int DEFAULT_IDLE_TIMEOUT = 60;
+
+std::chrono::seconds idleTimeout()
+{
+    char *env = getenv("ASKUSER_NOTIFICATION_IDLE_TIMEOUT");
+    return std::chrono::seconds(env ? std::atoi(env) : DEFAULT_IDLE_TIMEOUT);
+}
+
+bool sharedRing()
+{
+    char *env = getenv("ASKUSER_NOTIFICATION_TRANSPORT");
+    return env && std::string(env) == "ring";
+}
+
+} // namespace
+
 int main()
 {
     using namespace AskUser::Notification;
@@ -43,7 +63,7 @@ int main()
 
     try {
         GuiRunner gui;
-        AskUserTalker askUserTalker(&gui);
+        AskUserTalker askUserTalker(&gui, idleTimeout(), sharedRing());
 
         int ret = sd_notify(0, "READY=1");
         if (ret == 0) {
@@ -56,9 +76,11 @@ int main()
 
     } catch (std::exception &e) {
         ALOGE("Askuser-notification stopped because of: <" << e.what() << ">.");
+        return EXIT_FAILURE;
     } catch (...) {
         ALOGE("Askuser-notification stopped because of unknown unhandled exception.");
+        return EXIT_FAILURE;
     }
 
-    return 0;
+    return EXIT_SUCCESS;
 }
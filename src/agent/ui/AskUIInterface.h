@@ -38,6 +38,7 @@ typedef enum {
     URT_YES_ONCE,
     URT_YES_SESSION,
     URT_YES_LIFE,
+    URT_YES_TIMED,
     URT_TIMEOUT,
     URT_ERROR
 } UIResponseType;
@@ -48,8 +49,9 @@ class AskUIInterface {
 public:
     virtual ~AskUIInterface() {};
 
-    virtual bool start(const std::string &client, const std::string &user,
-                       const std::string &privilege, RequestId requestId, UIResponseCallback) = 0;
+    virtual bool start(const std::string &client, const std::string &package,
+                       const std::string &user, const std::string &privilege,
+                       RequestId requestId, UIResponseCallback) = 0;
     virtual bool setOutdated() = 0;
     virtual bool dismiss() = 0;
     virtual bool isDismissing() const = 0;
@@ -19,6 +19,8 @@
  * @brief       This file contains notification backend definition.
  */
 
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 #include <log/alog.h>
 
@@ -28,7 +30,19 @@ namespace AskUser {
 
 namespace Agent {
 
-NotificationTalker NotificationBackend::m_notiTalker;
+namespace {
+
+Socket::Type notificationSocketType()
+{
+    char *env = getenv("ASKUSER_NOTIFICATION_SOCKET");
+    if (env && strcmp(env, "seqpacket") == 0)
+        return Socket::Type::SeqPacket;
+    return Socket::Type::Stream;
+}
+
+} // namespace
+
+NotificationTalker NotificationBackend::m_notiTalker(Heartbeat(), notificationSocketType());
 std::map<RequestId, NotificationBackend *> NotificationBackend::m_idToInstance;
 std::mutex NotificationBackend::m_instanceGuard;
 
@@ -40,9 +54,9 @@ NotificationBackend::NotificationBackend() : m_id(-1), m_isDismissing(false)
     }
 }
 
-bool NotificationBackend::start(const std::string &client, const std::string &user,
-                                const std::string &privilege, RequestId requestId,
-                                UIResponseCallback callback)
+bool NotificationBackend::start(const std::string &client, const std::string &package,
+                                const std::string &user, const std::string &privilege,
+                                RequestId requestId, UIResponseCallback callback)
 {
     m_idToInstance[requestId] = this;
     m_id = requestId;
@@ -54,8 +68,9 @@ bool NotificationBackend::start(const std::string &client, const std::string &us
     }
 
     m_notiTalker.setResponseHandler(&NotificationBackend::responseCb);
-    m_notiTalker.parseRequest(RequestType::RT_Action,
-                              NotificationRequest(requestId, client, user, privilege));
+    NotificationRequest request(requestId, client, user, privilege);
+    request.package = package;
+    m_notiTalker.parseRequest(RequestType::RT_Action, std::move(request));
     return true;
 }
 
@@ -72,6 +87,9 @@ void NotificationBackend::responseCb(NotificationResponse response)
     case NResponseType::Allow:
         type = UIResponseType::URT_YES_LIFE;
         break;
+    case NResponseType::AllowTimed:
+        type = UIResponseType::URT_YES_TIMED;
+        break;
     case NResponseType::Deny:
         type = UIResponseType::URT_NO_ONCE;
         break;
@@ -84,6 +102,9 @@ void NotificationBackend::responseCb(NotificationResponse response)
     case NResponseType::None:
         type = UIResponseType::URT_TIMEOUT;
         break;
+    case NResponseType::Pong:
+        // Heartbeat is handled by NotificationTalker
+        return;
     }
     it->second->m_cb(response.id, type);
 }
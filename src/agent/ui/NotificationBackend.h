@@ -41,8 +41,9 @@ public:
     NotificationBackend();
     virtual ~NotificationBackend();
 
-    virtual bool start(const std::string &client, const std::string &user,
-                       const std::string &privilege, RequestId requestId, UIResponseCallback);
+    virtual bool start(const std::string &client, const std::string &package,
+                       const std::string &user, const std::string &privilege,
+                       RequestId requestId, UIResponseCallback);
     virtual bool setOutdated();
     virtual bool dismiss();
     virtual bool isDismissing() const;
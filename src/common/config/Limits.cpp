@@ -34,6 +34,10 @@ constexpr size_t sizeLimit = 8192;
 
 }
 
+size_t getSizeLimit() {
+    return sizeLimit;
+}
+
 void checkSizeLimit(size_t size) {
     if (size > sizeLimit)
         throw Exception("Size exceeds limits; limit: " +
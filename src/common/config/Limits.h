@@ -26,6 +26,7 @@
 namespace AskUser {
 namespace Limits {
 
+size_t getSizeLimit();
 void checkSizeLimit(size_t size);
 
 } // namespace Limits
@@ -30,5 +30,15 @@ const std::string &getSocketPath() {
     return socketPath;
 }
 
+const std::string &getPrivilegeGroupsPath() {
+    static std::string privilegeGroupsPath = "/etc/askuser/privilege-groups";
+    return privilegeGroupsPath;
+}
+
+const std::string &getPreAnswerRulesPath() {
+    static std::string preAnswerRulesPath = "/etc/askuser/rules";
+    return preAnswerRulesPath;
+}
+
 } // namespace Path
 } // namespace AskUser
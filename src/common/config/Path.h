@@ -27,6 +27,8 @@ namespace AskUser {
 namespace Path {
 
 const std::string &getSocketPath();
+const std::string &getPrivilegeGroupsPath();
+const std::string &getPreAnswerRulesPath();
 
 } // namespace Path
 } // namespace AskUser
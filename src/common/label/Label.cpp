@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        src/common/label/Label.cpp
+ * @brief       Definition of cynara client labels normalization
+ */
+
+#include "Label.h"
+
+namespace AskUser {
+namespace Label {
+
+namespace {
+
+constexpr char appPrefix[] = "User::App::";
+constexpr char pkgPrefix[] = "User::Pkg::";
+
+inline bool startsWith(const std::string &label, const char *prefix, size_t prefixSize) {
+    return label.compare(0, prefixSize, prefix) == 0;
+}
+
+} // namespace
+
+std::string appId(const std::string &label) {
+    constexpr size_t prefixSize = sizeof(appPrefix) - 1;
+    return startsWith(label, appPrefix, prefixSize) ? label.substr(prefixSize) : label;
+}
+
+std::string packageKey(const std::string &label, const PackageResolver &resolver) {
+    constexpr size_t appPrefixSize = sizeof(appPrefix) - 1;
+
+    std::string pkgId;
+    if (!startsWith(label, appPrefix, appPrefixSize)
+        || !resolver(label.substr(appPrefixSize), pkgId) || pkgId.empty()) {
+        return label;
+    }
+    return pkgPrefix + pkgId;
+}
+
+} // namespace Label
+} // namespace AskUser
@@ -0,0 +1,45 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        src/common/label/Label.h
+ * @brief       Normalization of cynara client labels
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace AskUser {
+namespace Label {
+
+/* Finds package of application, returns false if application is not known */
+typedef std::function<bool(const std::string &appId, std::string &pkgId)> PackageResolver;
+
+/* Application id as known to security-manager: label without "User::App::" prefix */
+std::string appId(const std::string &label);
+
+/*
+ * Key shared by all labels of one package. "User::App::<appId>" is resolved to its package
+ * label "User::Pkg::<pkgId>", which is its own key. Any other label, or application which
+ * cannot be resolved, is its own key, so application ids, package ids and other labels
+ * never share one. Prompts coalesced under this key are shared by all labels of the package.
+ * Resolving asks security-manager, so it is done by the agent, never inside cynara plugins.
+ */
+std::string packageKey(const std::string &label, const PackageResolver &resolver);
+
+} // namespace Label
+} // namespace AskUser
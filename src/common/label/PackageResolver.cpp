@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        src/common/label/PackageResolver.cpp
+ * @brief       Definition of application package resolution through security-manager
+ */
+
+#include "PackageResolver.h"
+
+#include <cstdlib>
+#include <memory>
+#include <security-manager.h>
+
+namespace AskUser {
+namespace Label {
+
+bool securityManagerPackage(const std::string &appId, std::string &pkgId) {
+    char *pkg = nullptr;
+    if (security_manager_get_app_pkgid(&pkg, appId.c_str()) != SECURITY_MANAGER_SUCCESS)
+        return false;
+
+    std::unique_ptr<char, decltype(&std::free)> pkgPtr(pkg, &std::free);
+    if (!pkg)
+        return false;
+    pkgId = pkg;
+    return true;
+}
+
+} // namespace Label
+} // namespace AskUser
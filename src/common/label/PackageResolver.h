@@ -0,0 +1,35 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        src/common/label/PackageResolver.h
+ * @brief       Resolution of application packages through security-manager
+ */
+
+#pragma once
+
+#include <string>
+
+namespace AskUser {
+namespace Label {
+
+/*
+ * Asks security-manager for package of application, usable as PackageResolver.
+ * Built only into components linked with security-manager, not into askuser-common.
+ */
+bool securityManagerPackage(const std::string &appId, std::string &pkgId);
+
+} // namespace Label
+} // namespace AskUser
@@ -0,0 +1,432 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        FramedConnection.cpp
+ * @brief       Implementation of FramedConnection class
+ */
+
+#include "FramedConnection.h"
+
+#include <algorithm>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <config/Limits.h>
+#include <exception/ErrnoException.h>
+#include <exception/Exception.h>
+#include <socket/Socket.h>
+
+namespace AskUser {
+
+namespace Socket {
+
+namespace {
+
+const std::size_t RECV_CHUNK = 4096;
+
+// Frame sizes reserved for control frames without data, they never reach the user
+const FrameSize RING_OFFER = 0xFFFFFFFF;
+const FrameSize RING_SWITCH = 0xFFFFFFFE;
+
+bool isControl(FrameSize header)
+{
+    return header >= RING_SWITCH;
+}
+
+std::size_t frameLength(FrameSize header)
+{
+    return sizeof(header) + (isControl(header) ? 0 : header);
+}
+
+} // namespace
+
+FramedConnection::FramedConnection(int fd)
+    : m_fd(fd), m_packets(fd != -1 && getType(fd) == Type::SeqPacket)
+{}
+
+FramedConnection::~FramedConnection()
+{
+    closeReceivedFds();
+}
+
+int FramedConnection::bell() const
+{
+    return m_ring ? m_ring->bell() : -1;
+}
+
+void FramedConnection::clearBell()
+{
+    if (m_ring)
+        m_ring->clearBell();
+}
+
+bool FramedConnection::offerRing()
+{
+    // Descriptors cannot wait in output, they are sent only with data socket takes right away
+    if (m_ring || socketOutputPending())
+        return true;
+
+    m_ring = RingTransport::create();
+    if (!sendSocket(RING_OFFER, nullptr, 0, nullptr, 0, &m_ring->fds()))
+        return false;
+    if (socketOutputPending() && m_output.size() == frameLength(RING_OFFER)) {
+        m_output.clear();
+        m_outputSent = 0;
+        m_ring.reset();
+    }
+    return true;
+}
+
+bool FramedConnection::send(const void *head, std::size_t headSize,
+                            const void *body, std::size_t bodySize)
+{
+    // Peer would refuse larger frame, and its size could not be stored in the prefix
+    Limits::checkSizeLimit(headSize + bodySize);
+    if (m_ringOutput) {
+        sendRing(head, headSize, body, bodySize);
+        return true;
+    }
+
+    return sendSocket(headSize + bodySize, head, headSize, body, bodySize);
+}
+
+bool FramedConnection::sendSocket(FrameSize header, const void *head, std::size_t headSize,
+                                  const void *body, std::size_t bodySize,
+                                  const std::vector<int> *fds)
+{
+    std::size_t sent = 0;
+
+    // Frames keep their order, if anything waits then socket is full anyway
+    if (!socketOutputPending()) {
+        iovec iov[3] = {{&header, sizeof(header)},
+                        {const_cast<void *>(head), headSize},
+                        {const_cast<void *>(body), bodySize}};
+        ssize_t result = trySend(m_fd, iov, bodySize ? 3 : (headSize ? 2 : 1), fds);
+        if (result < 0)
+            return false;
+
+        sent = result;
+        if (sent == frameLength(header))
+            return true;
+
+        m_output.clear();
+        m_outputSent = 0;
+    }
+
+    auto append = [&](const void *part, std::size_t partSize) {
+        std::size_t skip = std::min(sent, partSize);
+        m_output.append(static_cast<const char *>(part) + skip, partSize - skip);
+        sent -= skip;
+    };
+    append(&header, sizeof(header));
+    append(head, headSize);
+    append(body, bodySize);
+
+    return true;
+}
+
+void FramedConnection::sendRing(const void *head, std::size_t headSize,
+                                const void *body, std::size_t bodySize)
+{
+    iovec parts[2] = {{const_cast<void *>(head), headSize}, {const_cast<void *>(body), bodySize}};
+    bool wake = false;
+    if (m_ringPendingStart == m_ringPending.size()
+        && m_ring->output().push(parts, 2, headSize + bodySize, wake)) {
+        if (wake)
+            m_ring->wakePeer();
+        return;
+    }
+
+    FrameSize size = headSize + bodySize;
+    m_ringPending.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    m_ringPending.append(static_cast<const char *>(head), headSize);
+    m_ringPending.append(static_cast<const char *>(body), bodySize);
+}
+
+bool FramedConnection::flush()
+{
+    flushRing();
+
+    if (!socketOutputPending())
+        return true;
+    if (m_packets)
+        return flushPackets();
+
+    iovec iov = {&m_output[m_outputSent], m_output.size() - m_outputSent};
+    ssize_t result = trySend(m_fd, &iov, 1);
+    if (result < 0)
+        return false;
+
+    m_outputSent += result;
+    if (!socketOutputPending()) {
+        m_output.clear();
+        m_outputSent = 0;
+    }
+
+    return true;
+}
+
+bool FramedConnection::flushPackets()
+{
+    // Queued frames are sent separately, so that each of them stays one packet
+    while (socketOutputPending()) {
+        FrameSize header;
+        std::memcpy(&header, &m_output[m_outputSent], sizeof(header));
+        iovec iov = {&m_output[m_outputSent], frameLength(header)};
+        ssize_t result = trySend(m_fd, &iov, 1);
+        if (result < 0)
+            return false;
+        if (result == 0)
+            return true;
+
+        m_outputSent += result;
+    }
+
+    m_output.clear();
+    m_outputSent = 0;
+    return true;
+}
+
+void FramedConnection::flushRing()
+{
+    bool wakePeer = false;
+    while (m_ringPendingStart < m_ringPending.size()) {
+        FrameSize size;
+        std::memcpy(&size, &m_ringPending[m_ringPendingStart], sizeof(size));
+        iovec part = {&m_ringPending[m_ringPendingStart + sizeof(size)], size};
+        bool wake;
+        if (!m_ring->output().push(&part, 1, size, wake))
+            break;
+
+        wakePeer |= wake;
+        m_ringPendingStart += sizeof(size) + size;
+    }
+
+    if (m_ringPendingStart == m_ringPending.size()) {
+        m_ringPending.clear();
+        m_ringPendingStart = 0;
+    }
+    if (wakePeer)
+        m_ring->wakePeer();
+}
+
+bool FramedConnection::receive()
+{
+    releaseRing();
+
+    // Taken frames are dropped, so buffer does not grow with number of frames
+    if (m_inputStart == m_inputEnd) {
+        m_inputStart = m_inputEnd = 0;
+    } else if (m_inputStart > 0) {
+        std::memmove(m_input.data(), m_input.data() + m_inputStart, m_inputEnd - m_inputStart);
+        m_inputEnd -= m_inputStart;
+        m_inputStart = 0;
+    }
+
+    // Frame which did not arrive whole is read at once, packet always arrives whole
+    std::size_t wanted = RECV_CHUNK;
+    FrameSize size;
+    if (m_packets) {
+        wanted = sizeof(size) + Limits::getSizeLimit();
+    } else if (m_inputEnd >= sizeof(size)) {
+        std::memcpy(&size, m_input.data(), sizeof(size));
+        if (!isControl(size))
+            Limits::checkSizeLimit(size);
+        // First frame could be buffered whole already, when caller did not take it
+        if (m_inputEnd < frameLength(size))
+            wanted = std::max(wanted, frameLength(size) - m_inputEnd);
+    }
+    if (m_input.size() < m_inputEnd + wanted)
+        m_input.resize(m_inputEnd + wanted);
+
+    ssize_t result = tryRecv(m_fd, m_input.data() + m_inputEnd, m_input.size() - m_inputEnd,
+                             m_packets ? MSG_TRUNC : 0, &m_receivedFds);
+    // Only shared ring offer brings descriptors, anything else is not kept open
+    if (!m_receivedFds.empty() && (m_ring || m_receivedFds.size() > RingTransport::FDS))
+        closeReceivedFds();
+    if (result < 0)
+        return false;
+
+    if (m_packets && result > 0) {
+        // Truncated packet reports its real length
+        if (static_cast<std::size_t>(result) < sizeof(size))
+            throw Exception("Packet too short for frame: " + std::to_string(result));
+        Limits::checkSizeLimit(result - sizeof(size));
+        std::memcpy(&size, m_input.data() + m_inputEnd, sizeof(size));
+        if (frameLength(size) != static_cast<std::size_t>(result))
+            throw Exception("Packet size " + std::to_string(result) + " does not match frame size "
+                            + std::to_string(size));
+    }
+
+    m_inputEnd += result;
+    return true;
+}
+
+bool FramedConnection::complete(FrameSize &header, std::size_t &size) const
+{
+    std::size_t available = m_inputEnd - m_inputStart;
+    if (available < sizeof(header))
+        return false;
+
+    std::memcpy(&header, m_input.data() + m_inputStart, sizeof(header));
+    size = isControl(header) ? 0 : header;
+    if (!isControl(header))
+        Limits::checkSizeLimit(size);
+    return available - sizeof(header) >= size;
+}
+
+bool FramedConnection::peekFrame(Frame &frame, bool &fromRing)
+{
+    FrameSize header;
+    std::size_t size;
+    while (complete(header, size)) {
+        if (isControl(header)) {
+            m_inputStart += sizeof(header);
+            handleControl(header);
+            continue;
+        }
+
+        frame.data = m_input.data() + m_inputStart + sizeof(header);
+        frame.size = size;
+        fromRing = false;
+        return true;
+    }
+
+    // Peer sends nothing through socket after it switches to ring
+    if (!m_ringInput || !m_ring->input().peek(frame.data, frame.size))
+        return false;
+
+    fromRing = true;
+    return true;
+}
+
+bool FramedConnection::hasFrame()
+{
+    Frame frame;
+    bool fromRing;
+    return peekFrame(frame, fromRing);
+}
+
+bool FramedConnection::nextFrame(Frame &frame)
+{
+    releaseRing();
+
+    bool fromRing;
+    if (!peekFrame(frame, fromRing))
+        return false;
+
+    if (fromRing)
+        m_ring->input().take();
+    else
+        m_inputStart += sizeof(FrameSize) + frame.size;
+    return true;
+}
+
+void FramedConnection::handleControl(FrameSize header)
+{
+    if (header == RING_OFFER) {
+        if (m_ring) {
+            closeReceivedFds();
+            return;
+        }
+
+        std::vector<int> fds;
+        fds.swap(m_receivedFds);
+        m_ring = RingTransport::adopt(std::move(fds));
+        if (!m_ring)
+            return;
+
+        // Peer reads ring after all what was sent through socket before
+        if (!sendSocket(RING_SWITCH, nullptr, 0, nullptr, 0))
+            return;
+        m_ringOutput = true;
+        return;
+    }
+
+    if (!m_ring)
+        throw Exception("Peer switched to shared ring which does not exist");
+
+    m_ringInput = true;
+    if (!m_ringOutput && sendSocket(RING_SWITCH, nullptr, 0, nullptr, 0))
+        m_ringOutput = true;
+}
+
+void FramedConnection::releaseRing()
+{
+    if (m_ringInput && m_ring->input().release())
+        m_ring->wakePeer();
+}
+
+void FramedConnection::closeReceivedFds()
+{
+    for (int fd : m_receivedFds)
+        ::close(fd);
+    m_receivedFds.clear();
+}
+
+bool FramedConnection::waitFrame(Frame &frame)
+{
+    while (!nextFrame(frame)) {
+        short revents;
+        wait(POLLIN, -1, revents);
+        if (revents && !receive())
+            return false;
+    }
+
+    return true;
+}
+
+bool FramedConnection::waitFlushed()
+{
+    while (outputPending()) {
+        short revents;
+        wait(socketOutputPending() ? POLLOUT : 0, -1, revents);
+        if ((revents & (POLLHUP | POLLERR)) || !flush())
+            return false;
+    }
+
+    return true;
+}
+
+bool FramedConnection::waitInput(int timeoutMs)
+{
+    if (hasFrame())
+        return true;
+
+    short revents;
+    return wait(POLLIN, timeoutMs, revents) > 0;
+}
+
+int FramedConnection::wait(short events, int timeoutMs, short &revents)
+{
+    pollfd pfds[2] = {{m_fd, events, 0}, {bell(), POLLIN, 0}};
+    int ret = TEMP_FAILURE_RETRY(poll(pfds, m_ring ? 2 : 1, timeoutMs));
+    if (ret == -1)
+        throw ErrnoException("Waiting for socket failed");
+
+    if (pfds[1].revents & POLLIN)
+        m_ring->clearBell();
+    revents = pfds[0].revents;
+    return ret;
+}
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        FramedConnection.h
+ * @brief       Declaration of FramedConnection class
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <socket/SharedRing.h>
+
+namespace AskUser {
+
+namespace Socket {
+
+// Every frame is preceded by its size
+typedef uint32_t FrameSize;
+
+struct Frame {
+    const char *data = nullptr;
+    std::size_t size = 0;
+};
+
+/*
+ * Frames over stream socket, which may transfer only part of data at once, or over seqpacket
+ * socket, where every frame is sent and received whole as one packet.
+ * One side may offer shared memory rings, after both sides switch to them frames do not go
+ * through the socket anymore, it only tells that peer is gone.
+ * Nothing blocks, except wait* methods meant for peers without event loop.
+ */
+class FramedConnection {
+public:
+    explicit FramedConnection(int fd = -1);
+    ~FramedConnection();
+
+    FramedConnection(FramedConnection &&) = default;
+    FramedConnection &operator=(FramedConnection &&) = default;
+
+    int fd() const {
+        return m_fd;
+    }
+
+    /* Eventfd signalled when shared ring has frames or room for them, -1 without rings */
+    int bell() const;
+    void clearBell();
+
+    /* Sends shared rings to peer, they are used once peer accepts them */
+    bool offerRing();
+
+    /*
+     * Sends frame of head and body in one call, what socket or ring does not take waits for
+     * flush(). Returns false when connection is closed by peer, throws if frame exceeds size
+     * limit.
+     */
+    bool send(const void *head, std::size_t headSize,
+              const void *body = nullptr, std::size_t bodySize = 0);
+    bool flush();
+    bool outputPending() const {
+        return socketOutputPending() || m_ringPendingStart < m_ringPending.size();
+    }
+    bool socketOutputPending() const {
+        return m_outputSent < m_output.size();
+    }
+
+    /* Reads what has arrived through socket, returns false when connection is closed by peer */
+    bool receive();
+    /* Takes next complete frame, its data stays valid until next nextFrame() or receive() */
+    bool nextFrame(Frame &frame);
+    bool hasFrame();
+
+    bool waitFrame(Frame &frame);
+    bool waitFlushed();
+    /* Waits until frame or end of connection can be received, returns false on timeout */
+    bool waitInput(int timeoutMs);
+
+private:
+    bool peekFrame(Frame &frame, bool &fromRing);
+    bool complete(FrameSize &header, std::size_t &size) const;
+    void handleControl(FrameSize header);
+    bool sendSocket(FrameSize header, const void *head, std::size_t headSize,
+                    const void *body, std::size_t bodySize, const std::vector<int> *fds = nullptr);
+    bool flushPackets();
+    void sendRing(const void *head, std::size_t headSize, const void *body, std::size_t bodySize);
+    void flushRing();
+    void releaseRing();
+    void closeReceivedFds();
+    int wait(short events, int timeoutMs, short &revents);
+
+    int m_fd;
+    bool m_packets;
+
+    std::string m_output;
+    std::size_t m_outputSent = 0;
+
+    // Received data not taken yet starts at m_inputStart, buffer is reused for next frames
+    std::vector<char> m_input;
+    std::size_t m_inputStart = 0;
+    std::size_t m_inputEnd = 0;
+    std::vector<int> m_receivedFds;
+
+    std::unique_ptr<RingTransport> m_ring;
+    // Own frames go through ring, peer's frames come through ring
+    bool m_ringOutput = false;
+    bool m_ringInput = false;
+    // Frames waiting for room in ring
+    std::string m_ringPending;
+    std::size_t m_ringPendingStart = 0;
+};
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        Poller.cpp
+ * @brief       Definition of Poller class
+ */
+
+#include "Poller.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+#include <exception/ErrnoException.h>
+
+namespace AskUser {
+
+namespace Socket {
+
+Poller::Poller(int maxEvents) : m_events(maxEvents) {
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == -1)
+        throw ErrnoException("Epoll creation failed");
+}
+
+Poller::~Poller() {
+    ::close(m_epollFd);
+}
+
+void Poller::add(int fd, uint32_t events) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+        throw ErrnoException("Adding descriptor to epoll failed");
+}
+
+void Poller::modify(int fd, uint32_t events) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event) == -1)
+        throw ErrnoException("Modifying descriptor in epoll failed");
+}
+
+void Poller::remove(int fd) {
+    for (int i = 0; i < m_ready; ++i) {
+        if (m_events[i].data.fd == fd) {
+            m_events[i].data.fd = -1;
+            m_events[i].events = 0;
+        }
+    }
+
+    // Descriptor could be closed already, which removes it from epoll as well
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr) == -1 && errno != EBADF
+        && errno != ENOENT) {
+        throw ErrnoException("Removing descriptor from epoll failed");
+    }
+}
+
+int Poller::wait(int timeoutMs) {
+    m_ready = 0;
+    int result = epoll_wait(m_epollFd, m_events.data(), m_events.size(), timeoutMs);
+    if (result == -1) {
+        if (errno == EINTR)
+            return 0;
+        throw ErrnoException("Epoll wait failed");
+    }
+
+    m_ready = result;
+    return result;
+}
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        Poller.h
+ * @brief       Declaration of Poller class
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <sys/epoll.h>
+
+namespace AskUser {
+
+namespace Socket {
+
+/*
+ * Persistent epoll registration of descriptors. Unlike SelectRead, descriptors are not
+ * re-added before every wait and wait() reports only descriptors which are ready.
+ */
+class Poller {
+public:
+    static const uint32_t Read = EPOLLIN;
+    static const uint32_t Write = EPOLLOUT;
+    static const uint32_t EdgeTriggered = EPOLLET;
+    // Reported regardless of requested events
+    static const uint32_t Hangup = EPOLLHUP | EPOLLERR;
+
+    Poller(int maxEvents = 64);
+    ~Poller();
+
+    Poller(const Poller &) = delete;
+    Poller &operator=(const Poller &) = delete;
+
+    void add(int fd, uint32_t events = Read);
+    void modify(int fd, uint32_t events);
+    /*
+     * Also drops events of descriptor reported by last wait(), so they do not reach other
+     * descriptor which gets the same number while they are handled.
+     */
+    void remove(int fd);
+
+    /* Returns number of ready descriptors, 0 on timeout or signal */
+    int wait(int timeoutMs);
+
+    /* Ready descriptor, -1 if it was removed after wait() */
+    int fd(int i) const {
+        return m_events[i].data.fd;
+    }
+
+    uint32_t events(int i) const {
+        return m_events[i].events;
+    }
+
+private:
+    int m_epollFd;
+    std::vector<epoll_event> m_events;
+    int m_ready = 0;
+};
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -27,7 +27,7 @@ namespace AskUser {
 
 namespace Socket {
 
-SelectRead::SelectRead() : m_exec(true), m_timeout({0, 0}) {}
+SelectRead::SelectRead() : m_exec(true), m_nfds(-1), m_timeout({0, 0}) {}
 
 void SelectRead::add(int fd) {
     if (m_exec) {
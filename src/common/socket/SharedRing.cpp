@@ -0,0 +1,300 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        SharedRing.cpp
+ * @brief       Implementation of SharedRing and RingTransport classes
+ */
+
+#include "SharedRing.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <exception/ErrnoException.h>
+#include <exception/Exception.h>
+#include <log/alog.h>
+
+namespace AskUser {
+
+namespace Socket {
+
+namespace {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Shared ring needs lock-free atomics");
+
+// Rest of ring up to its end is skipped, record did not fit there
+const uint32_t WRAP = 0xFFFFFFFF;
+const std::size_t RING_SIZE = sizeof(SharedRing::Header) + SharedRing::CAPACITY;
+const std::size_t MEMORY_SIZE = 2 * RING_SIZE;
+const unsigned int REQUIRED_SEALS = F_SEAL_SHRINK | F_SEAL_GROW;
+
+void throwCorrupted()
+{
+    throw Exception("Shared ring corrupted by peer");
+}
+
+bool isEventFd(int fd)
+{
+    char link[64];
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    ssize_t length = readlink(path.c_str(), link, sizeof(link) - 1);
+    if (length == -1)
+        return false;
+    link[length] = '\0';
+    return strcmp(link, "anon_inode:[eventfd]") == 0;
+}
+
+} // namespace
+
+std::size_t SharedRing::padded(std::size_t size)
+{
+    return (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+uint32_t SharedRing::readSize(uint32_t position) const
+{
+    uint32_t size;
+    memcpy(&size, m_data + (position & (CAPACITY - 1)), sizeof(size));
+    return size;
+}
+
+bool SharedRing::push(const iovec *parts, int count, std::size_t size, bool &wake)
+{
+    wake = false;
+    if (size > MAX_RECORD)
+        throw Exception("Record of " + std::to_string(size) + " bytes exceeds shared ring");
+
+    std::size_t record = padded(sizeof(uint32_t) + size);
+    std::size_t toEnd = CAPACITY - (m_head & (CAPACITY - 1));
+    std::size_t needed = record <= toEnd ? record : toEnd + record;
+
+    auto hasRoom = [&]() {
+        uint32_t used = m_head - m_header->tail.load(std::memory_order_seq_cst);
+        if (used > CAPACITY)
+            throwCorrupted();
+        return CAPACITY - used >= needed;
+    };
+    if (!hasRoom()) {
+        // Consumer which releases records from now on sees producer waits
+        m_header->producerWaiting.store(1, std::memory_order_seq_cst);
+        if (!hasRoom())
+            return false;
+        m_header->producerWaiting.store(0, std::memory_order_relaxed);
+    }
+
+    if (record > toEnd) {
+        memcpy(m_data + (m_head & (CAPACITY - 1)), &WRAP, sizeof(WRAP));
+        m_head += toEnd;
+    }
+
+    char *out = m_data + (m_head & (CAPACITY - 1));
+    uint32_t recordSize = size;
+    memcpy(out, &recordSize, sizeof(recordSize));
+    out += sizeof(recordSize);
+    for (int i = 0; i < count; ++i) {
+        memcpy(out, parts[i].iov_base, parts[i].iov_len);
+        out += parts[i].iov_len;
+    }
+
+    m_head += record;
+    m_header->head.store(m_head, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake = m_header->consumerWaiting.exchange(0) != 0;
+    return true;
+}
+
+bool SharedRing::peek(const char *&data, std::size_t &size)
+{
+    for (;;) {
+        uint32_t head = m_header->head.load(std::memory_order_acquire);
+        if (head == m_cursor) {
+            // Producer which adds record from now on sees consumer waits
+            m_header->consumerWaiting.store(1, std::memory_order_seq_cst);
+            head = m_header->head.load(std::memory_order_seq_cst);
+            if (head == m_cursor)
+                return false;
+            m_header->consumerWaiting.store(0, std::memory_order_relaxed);
+        }
+
+        uint32_t available = head - m_cursor;
+        std::size_t toEnd = CAPACITY - (m_cursor & (CAPACITY - 1));
+        if (available > CAPACITY || available < sizeof(uint32_t))
+            throwCorrupted();
+
+        // Size is read once, peer could change it any time
+        uint32_t recordSize = readSize(m_cursor);
+        if (recordSize == WRAP) {
+            if (toEnd > available)
+                throwCorrupted();
+            m_cursor += toEnd;
+            continue;
+        }
+
+        std::size_t record = padded(sizeof(recordSize) + recordSize);
+        if (recordSize > MAX_RECORD || record > available || record > toEnd)
+            throwCorrupted();
+
+        data = m_data + (m_cursor & (CAPACITY - 1)) + sizeof(recordSize);
+        size = recordSize;
+        m_peeked = record;
+        return true;
+    }
+}
+
+void SharedRing::take()
+{
+    m_cursor += m_peeked;
+    m_peeked = 0;
+}
+
+bool SharedRing::release()
+{
+    if (m_cursor == m_released)
+        return false;
+
+    m_released = m_cursor;
+    m_header->tail.store(m_cursor, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_header->producerWaiting.exchange(0) != 0;
+}
+
+RingTransport::RingTransport(std::vector<int> &&fds, bool creator)
+    : m_fds(std::move(fds)), m_creator(creator)
+{}
+
+RingTransport::~RingTransport()
+{
+    if (m_memory)
+        munmap(m_memory, MEMORY_SIZE);
+    for (int fd : m_fds)
+        ::close(fd);
+}
+
+std::unique_ptr<RingTransport> RingTransport::create()
+{
+    std::unique_ptr<RingTransport> transport(new RingTransport({}, true));
+
+    int memFd = memfd_create("askuser-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memFd == -1)
+        throw ErrnoException("Creating shared ring memory failed");
+    transport->m_fds.push_back(memFd);
+
+    // Peer must not be able to shrink memory mapped by the other side
+    if (ftruncate(memFd, MEMORY_SIZE) == -1
+        || fcntl(memFd, F_ADD_SEALS, REQUIRED_SEALS | F_SEAL_SEAL) == -1) {
+        throw ErrnoException("Preparing shared ring memory failed");
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        int bell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (bell == -1)
+            throw ErrnoException("Creating shared ring eventfd failed");
+        transport->m_fds.push_back(bell);
+    }
+
+    if (!transport->map())
+        throw ErrnoException("Mapping shared ring memory failed");
+
+    return transport;
+}
+
+std::unique_ptr<RingTransport> RingTransport::adopt(std::vector<int> &&fds)
+{
+    std::unique_ptr<RingTransport> transport(new RingTransport(std::move(fds), false));
+    const std::vector<int> &adopted = transport->m_fds;
+    if (adopted.size() != FDS) {
+        ALOGE("Shared ring offered with " << adopted.size() << " descriptors");
+        return nullptr;
+    }
+
+    struct stat memStat;
+    int seals = fcntl(adopted[0], F_GET_SEALS);
+    if (fstat(adopted[0], &memStat) == -1
+        || static_cast<std::size_t>(memStat.st_size) != MEMORY_SIZE
+        || seals == -1 || (seals & REQUIRED_SEALS) != REQUIRED_SEALS) {
+        ALOGE("Shared ring memory is not sealed or has wrong size");
+        return nullptr;
+    }
+
+    // Waking and clearing bells must never block
+    for (std::size_t i = 1; i < FDS; ++i) {
+        int flags = fcntl(adopted[i], F_GETFL);
+        if (!isEventFd(adopted[i]) || flags == -1
+            || fcntl(adopted[i], F_SETFL, flags | O_NONBLOCK) == -1) {
+            ALOGE("Shared ring bell is not eventfd");
+            return nullptr;
+        }
+    }
+
+    if (!transport->map()) {
+        ALOGE("Mapping shared ring memory failed: " << errno);
+        return nullptr;
+    }
+
+    return transport;
+}
+
+bool RingTransport::map()
+{
+    m_memory = mmap(nullptr, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, m_fds[0], 0);
+    if (m_memory == MAP_FAILED) {
+        m_memory = nullptr;
+        return false;
+    }
+
+    // First ring goes from creator to adopter
+    char *memory = static_cast<char *>(m_memory);
+    SharedRing rings[2];
+    for (int i = 0; i < 2; ++i) {
+        char *ring = memory + i * RING_SIZE;
+        rings[i] = SharedRing(reinterpret_cast<SharedRing::Header *>(ring),
+                              ring + sizeof(SharedRing::Header));
+    }
+    m_output = rings[m_creator ? 0 : 1];
+    m_input = rings[m_creator ? 1 : 0];
+    return true;
+}
+
+int RingTransport::bell() const
+{
+    return m_fds[m_creator ? 1 : 2];
+}
+
+void RingTransport::wakePeer()
+{
+    uint64_t one = 1;
+    if (TEMP_FAILURE_RETRY(::write(m_fds[m_creator ? 2 : 1], &one, sizeof(one))) == -1
+        && errno != EAGAIN) {
+        throw ErrnoException("Waking shared ring peer failed");
+    }
+}
+
+void RingTransport::clearBell()
+{
+    uint64_t count;
+    if (TEMP_FAILURE_RETRY(::read(bell(), &count, sizeof(count))) == -1 && errno != EAGAIN)
+        throw ErrnoException("Clearing shared ring bell failed");
+}
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        SharedRing.h
+ * @brief       Declaration of SharedRing and RingTransport classes
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/uio.h>
+#include <vector>
+
+namespace AskUser {
+
+namespace Socket {
+
+/*
+ * Single producer, single consumer ring of records in memory shared with other process.
+ * Record is stored whole, so consumer reads it in place. Producer only moves head, consumer
+ * only moves tail, and each side announces it is going to sleep, so the other one knows
+ * when it has to be woken up.
+ * Peer may be malicious, so positions and sizes read from shared memory are checked.
+ */
+class SharedRing {
+public:
+    struct Header {
+        alignas(64) std::atomic<uint32_t> head;
+        std::atomic<uint32_t> producerWaiting;
+        alignas(64) std::atomic<uint32_t> tail;
+        std::atomic<uint32_t> consumerWaiting;
+    };
+
+    static const std::size_t CAPACITY = 64 * 1024;
+    // Record does not fit into ring, if its padding up to the end and record itself do not
+    static const std::size_t MAX_RECORD = CAPACITY / 2 - sizeof(uint32_t);
+
+    SharedRing(Header *header = nullptr, char *data = nullptr)
+        : m_header(header), m_data(data) {}
+
+    /*
+     * Copies parts into ring as one record of given size. Returns false when there is no room,
+     * producer is then woken when consumer releases some. Sets wake if consumer sleeps.
+     */
+    bool push(const iovec *parts, int count, std::size_t size, bool &wake);
+
+    /* Record at read position, it stays in ring until release() */
+    bool peek(const char *&data, std::size_t &size);
+    void take();
+    /* Gives taken records back to producer, returns true if producer waits for room */
+    bool release();
+
+private:
+    static std::size_t padded(std::size_t size);
+    uint32_t readSize(uint32_t position) const;
+
+    Header *m_header;
+    char *m_data;
+
+    // Own positions are kept locally, peer could overwrite the shared ones
+    uint32_t m_head = 0;
+    uint32_t m_cursor = 0;
+    uint32_t m_released = 0;
+    std::size_t m_peeked = 0;
+};
+
+/*
+ * Two shared rings, one for each direction, in memfd passed to peer with SCM_RIGHTS.
+ * Each side sleeps on its own eventfd bell and rings the bell of the other one.
+ */
+class RingTransport {
+public:
+    // Descriptors passed to peer: memfd, creator bell, adopter bell
+    static const std::size_t FDS = 3;
+
+    ~RingTransport();
+
+    RingTransport(const RingTransport &) = delete;
+    RingTransport &operator=(const RingTransport &) = delete;
+
+    /* Creates sealed memory and bells, descriptors are meant to be sent to peer */
+    static std::unique_ptr<RingTransport> create();
+    /* Takes descriptors received from creator, returns nullptr if they are not valid */
+    static std::unique_ptr<RingTransport> adopt(std::vector<int> &&fds);
+
+    const std::vector<int> &fds() const {
+        return m_fds;
+    }
+
+    SharedRing &input() {
+        return m_input;
+    }
+
+    SharedRing &output() {
+        return m_output;
+    }
+
+    int bell() const;
+    void wakePeer();
+    void clearBell();
+
+private:
+    RingTransport(std::vector<int> &&fds, bool creator);
+    bool map();
+
+    std::vector<int> m_fds;
+    bool m_creator;
+    void *m_memory = nullptr;
+    SharedRing m_input;
+    SharedRing m_output;
+};
+
+} /* namespace Socket */
+
+} /* namespace AskUser */
@@ -24,6 +24,8 @@
 #include <exception/ErrnoException.h>
 #include <log/alog.h>
 
+#include <cstring>
+#include <fcntl.h>
 #include <stdexcept>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -33,6 +35,17 @@ namespace AskUser {
 
 namespace Socket {
 
+namespace {
+
+// Shared ring memory and its two bells
+const std::size_t MAX_PASSED_FDS = 3;
+
+int nativeType(Type type) {
+    return type == Type::SeqPacket ? SOCK_SEQPACKET : SOCK_STREAM;
+}
+
+} // namespace
+
 int accept(int fd) {
     int retFd = TEMP_FAILURE_RETRY(::accept(fd, nullptr, nullptr));
     if (retFd < 0)
@@ -53,7 +66,7 @@ void close(int fd) {
     ALOGD("Closed socket <" << fd << ">");
 }
 
-int connect(const std::string &path) {
+int connect(const std::string &path, Type type) {
     int fd = -1;
     int result = 0;
     size_t length = 0;
@@ -67,11 +80,16 @@ int connect(const std::string &path) {
 
     length = strlen(remote.sun_path) + sizeof(remote.sun_family);
 
-    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    fd = ::socket(AF_UNIX, nativeType(type), 0);
     if (fd == -1)
         throw ErrnoException("Socket creation failed");
 
     result = TEMP_FAILURE_RETRY(::connect(fd, (struct sockaddr *)&remote, length));
+    if (result == -1 && errno == EPROTOTYPE && type == Type::SeqPacket) {
+        ALOGD("Socket <" << path << "> does not support SOCK_SEQPACKET, using SOCK_STREAM");
+        close(fd);
+        return connect(path, Type::Stream);
+    }
     if (result == -1)
         throw ErrnoException("Connecting to <" + path + "> socket failed");
 
@@ -80,7 +98,7 @@ int connect(const std::string &path) {
     return fd;
 }
 
-int listen(const std::string &path) {
+int listen(const std::string &path, Type type) {
     int fd = -1;
     int result = 0;
     size_t length = 0;
@@ -98,7 +116,7 @@ int listen(const std::string &path) {
     if (result == -1 && errno != ENOENT)
         throw ErrnoException("Unlink " + path + " failed");
 
-    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    fd = ::socket(AF_UNIX, nativeType(type), 0);
     if (fd == -1)
         throw ErrnoException("Socket creation failed");
 
@@ -115,12 +133,22 @@ int listen(const std::string &path) {
     return fd;
 }
 
+Type getType(int fd) {
+    int type;
+    socklen_t length = sizeof(type);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) == -1)
+        throw ErrnoException("Getting type of socket <" + std::to_string(fd) + "> failed");
+
+    return type == SOCK_SEQPACKET ? Type::SeqPacket : Type::Stream;
+}
+
 bool recv(int fd, void *buf, size_t size, int flags) {
     int result = 0;
     size_t bytesRead = 0;
 
     while (bytesRead < size) {
-        result = TEMP_FAILURE_RETRY(::recv(fd, buf, size, flags));
+        result = TEMP_FAILURE_RETRY(::recv(fd, static_cast<char *>(buf) + bytesRead,
+                                           size - bytesRead, flags));
 
         if (result < 0 && errno != ECONNRESET)
             throw ErrnoException("Error receiving data from socket");
@@ -141,7 +169,8 @@ bool send(int fd, const void *buf, size_t size, int flags) {
 
     while (bytesSend < size) {
 
-        result = TEMP_FAILURE_RETRY(::send(fd, buf, size, flags | MSG_NOSIGNAL));
+        result = TEMP_FAILURE_RETRY(::send(fd, static_cast<const char *>(buf) + bytesSend,
+                                           size - bytesSend, flags | MSG_NOSIGNAL));
 
         if (result < 0) {
             if (errno == EPIPE)
@@ -158,6 +187,80 @@ bool send(int fd, const void *buf, size_t size, int flags) {
     return true;
 }
 
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        throw ErrnoException("Setting socket <" + std::to_string(fd) + "> non-blocking failed");
+}
+
+ssize_t trySend(int fd, const struct iovec *iov, int iovcnt, const std::vector<int> *fds) {
+    msghdr msg = {};
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovcnt;
+
+    char control[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)] = {};
+    if (fds && !fds->empty()) {
+        if (fds->size() > MAX_PASSED_FDS)
+            throw std::invalid_argument("Too many descriptors to pass");
+
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds->size());
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds->size());
+        memcpy(CMSG_DATA(cmsg), fds->data(), sizeof(int) * fds->size());
+    }
+
+    ssize_t result = TEMP_FAILURE_RETRY(::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT));
+    if (result >= 0) {
+        ALOGD("Send " << result << " byte(s)");
+        return result;
+    }
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return 0;
+    if (errno == EPIPE || errno == ECONNRESET)
+        return -1;
+    throw ErrnoException("Error sending data to socket");
+}
+
+ssize_t tryRecv(int fd, void *buf, size_t size, int flags, std::vector<int> *fds) {
+    ssize_t result;
+    if (!fds) {
+        result = TEMP_FAILURE_RETRY(::recv(fd, buf, size, flags | MSG_DONTWAIT));
+    } else {
+        iovec iov = {buf, size};
+        char control[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        result = TEMP_FAILURE_RETRY(::recvmsg(fd, &msg, flags | MSG_DONTWAIT | MSG_CMSG_CLOEXEC));
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); result >= 0 && cmsg;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *passed = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            fds->insert(fds->end(), passed, passed + count);
+        }
+    }
+
+    if (result > 0) {
+        ALOGD("Recieved " << result << " byte(s)");
+        return result;
+    }
+
+    if (result == 0 || errno == ECONNRESET)
+        return -1;
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return 0;
+    throw ErrnoException("Error receiving data from socket");
+}
+
 } /* namespace Socket */
 
 } /* namespace AskUser */
@@ -23,18 +23,39 @@
 
 #include <cstddef>
 #include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
 
 namespace AskUser {
 
 namespace Socket {
 
+enum class Type {
+    Stream,
+    // Keeps message boundaries, so every frame is a single send and recv
+    SeqPacket
+};
+
 int accept(int fd);
 void close(int fd);
-int connect(const std::string &path);
-int listen(const std::string &path);
+/* SeqPacket connection falls back to Stream if listening socket is of that type */
+int connect(const std::string &path, Type type = Type::Stream);
+int listen(const std::string &path, Type type = Type::Stream);
+Type getType(int fd);
 bool recv(int fd, void *buf, size_t size, int flags = 0);
 bool send(int fd, const void *buf, size_t size, int flags = 0);
 
+void setNonBlocking(int fd);
+/*
+ * Transfer as much as socket accepts without blocking. Return number of bytes transferred,
+ * 0 if socket is not ready, -1 if connection is closed by peer.
+ * Descriptors are passed along with data, received ones are appended to fds.
+ */
+ssize_t trySend(int fd, const struct iovec *iov, int iovcnt,
+                const std::vector<int> *fds = nullptr);
+ssize_t tryRecv(int fd, void *buf, size_t size, int flags = 0, std::vector<int> *fds = nullptr);
+
 } /* namespace Socket */
 
 } /* namespace AskUser */
@@ -24,6 +24,7 @@
 
 #include <types/AgentErrorMsg.h>
 
+#include <cctype>
 #include <limits>
 #include <stdexcept>
 #include <sstream>
@@ -99,40 +100,91 @@ std::string responseToString(NResponseType response)
     switch (response) {
     case NResponseType::Allow:
         return "Allow";
+    case NResponseType::AllowTimed:
+        return "Allow for limited time";
     case NResponseType::Deny:
         return "Deny once";
     case NResponseType::Never:
         return "Deny";
     case NResponseType::Error:
         return "Error";
+    case NResponseType::Pong:
+        return "Pong";
     default:
         return "None";
     }
 }
 
-NotificationRequest dataToNotificationRequest(const std::string &data) {
-    std::stringstream stream(data);
-    std::size_t strSize;
-    char separator;
+namespace {
 
-    cynara_agent_req_id id;
-    std::string members[2];
+std::size_t decimalLength(unsigned long long value) {
+    std::size_t length = 1;
+    for (; value >= 10; value /= 10)
+        ++length;
+    return length;
+}
 
-    stream >> id;
-    stream.read(&separator, 1);
+/*
+ * Reads data in place, without copying it into stream. Strings go into storage of
+ * request read into, so request reused for next data does not allocate if it fits.
+ */
+class RequestReader {
+public:
+    RequestReader(const char *data, std::size_t size) : m_pos(data), m_end(data + size) {}
+
+    bool read(NotificationRequest &request) {
+        unsigned long long id;
+        if (!number(id) || id > std::numeric_limits<RequestId>::max() || !skip())
+            return false;
+        request.id = static_cast<RequestId>(id);
+        request.data.user.clear();
+        return text(request.data.client) && text(request.data.privilege);
+    }
 
-    for (auto &member : members) {
-        stream >> strSize;
-        std::vector<char> buffer(strSize, '\0');
-        char separator;
-        //Consume separator
-        stream.read(&separator, 1);
-        stream.read(buffer.data(), strSize);
-        //read doesn't append null
-        member.assign(buffer.begin(), buffer.end());
+    bool number(unsigned long long &value) {
+        while (m_pos != m_end && std::isspace(static_cast<unsigned char>(*m_pos)))
+            ++m_pos;
+
+        const char *start = m_pos;
+        value = 0;
+        for (; m_pos != m_end && std::isdigit(static_cast<unsigned char>(*m_pos)); ++m_pos) {
+            unsigned digit = *m_pos - '0';
+            if (value > (std::numeric_limits<unsigned long long>::max() - digit) / 10)
+                return false;
+            value = value * 10 + digit;
+        }
+        return m_pos != start;
+    }
+
+private:
+    bool skip() {
+        if (m_pos == m_end)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    // Text is preceded by its size and separator
+    bool text(std::string &out) {
+        unsigned long long size;
+        if (!number(size) || !skip() || size > static_cast<std::size_t>(m_end - m_pos))
+            return false;
+        out.assign(m_pos, size);
+        m_pos += size;
+        return true;
     }
 
-    return NotificationRequest({id, std::move(members[0]), "", std::move(members[1])});
+    const char *m_pos;
+    const char *m_end;
+};
+
+} // namespace
+
+NotificationRequest dataToNotificationRequest(const std::string &data) {
+    NotificationRequest request(0);
+    // Malformed data gives what could be read
+    RequestReader(data.data(), data.size()).read(request);
+    return request;
 }
 
 std::string notificationRequestToData(RequestId id, const std::string &client,
@@ -144,6 +196,55 @@ std::string notificationRequestToData(RequestId id, const std::string &client,
          std::to_string(privilege.length()) + separator + privilege + separator + separator;
 }
 
+std::vector<NotificationRequest> dataToNotificationRequests(const std::string &data) {
+    std::vector<NotificationRequest> requests;
+    dataToNotificationRequests(data.data(), data.size(), requests);
+    return requests;
+}
+
+void dataToNotificationRequests(const char *data, std::size_t size,
+                                std::vector<NotificationRequest> &requests)
+{
+    RequestReader reader(data, size);
+    unsigned long long count;
+    if (!reader.number(count))
+        throw TranslateErrorException("Malformed notification requests data");
+
+    // Count is not trusted, requests are added only as they are read
+    std::size_t i = 0;
+    for (; i < count; ++i) {
+        if (i == requests.size())
+            requests.emplace_back(0);
+        if (!reader.read(requests[i]))
+            throw TranslateErrorException("Malformed notification requests data");
+    }
+    requests.erase(requests.begin() + i, requests.end());
+}
+
+std::string notificationRequestsToData(const std::vector<NotificationRequest> &requests)
+{
+    const char separator = ' ';
+    std::string data = std::to_string(requests.size()) + separator;
+    for (const auto &request : requests)
+        data += notificationRequestToData(request.id, request.data.client,
+                                          request.data.privilege);
+    return data;
+}
+
+std::size_t notificationRequestDataSize(const NotificationRequest &request)
+{
+    const std::size_t separators = 6;
+    const std::string &client = request.data.client;
+    const std::string &privilege = request.data.privilege;
+    return decimalLength(request.id) + decimalLength(client.length()) + client.length()
+           + decimalLength(privilege.length()) + privilege.length() + separators;
+}
+
+std::size_t notificationRequestsDataSize(std::size_t count, std::size_t requestsDataSize)
+{
+    return decimalLength(count) + sizeof(' ') + requestsDataSize;
+}
+
 } //namespace Gui
 } //namespace Translator
 } //namespace AskUser
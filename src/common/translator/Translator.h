@@ -30,6 +30,7 @@
 
 #include <exception>
 #include <string>
+#include <vector>
 
 namespace AskUser {
 namespace Translator {
@@ -62,6 +63,15 @@ std::string responseToString(NResponseType response);
 NotificationRequest dataToNotificationRequest(const std::string &data);
 std::string notificationRequestToData(RequestId id, const std::string &client,
                                       const std::string &privilege);
+// Requests of one package shown together in one popup
+std::vector<NotificationRequest> dataToNotificationRequests(const std::string &data);
+// Decodes into given requests, reusing their strings, so decoding same sized data does not allocate
+void dataToNotificationRequests(const char *data, std::size_t size,
+                                std::vector<NotificationRequest> &requests);
+std::string notificationRequestsToData(const std::vector<NotificationRequest> &requests);
+// Sizes of data made by functions above, computed without making it
+std::size_t notificationRequestDataSize(const NotificationRequest &request);
+std::size_t notificationRequestsDataSize(std::size_t count, std::size_t requestsDataSize);
 } // namespace Gui
 } // namespace Translator
 } // namespace AskUser
@@ -35,6 +35,8 @@ struct NotificationRequest {
     {}
     RequestId id;
     RequestData data;
+    // Package key of client (see Label::packageKey), known to agent only, not sent to daemon
+    std::string package;
 };
 
 } // namespace AskUser
@@ -33,7 +33,10 @@ enum class NResponseType
     Deny,
     Never,
     Error,
-    None
+    None,
+    AllowTimed,
+    // Answer to Protocol::pingCode, not a decision
+    Pong
 };
 
 struct NotificationResponse {
@@ -21,13 +21,31 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace AskUser {
 namespace Protocol {
 
+/*
+ * Messages are sent in Socket::FramedConnection frames. Notification daemon sends
+ * NotificationResponse, every message from askuser starts with one of the codes:
+ *  requestCode serialized requests of one package, up to end of frame
+ *  dissmisCode RequestId of request to be dismissed
+ *  ackCode     RequestId of request which response was accepted
+ *  pingCode    no data, notification daemon answers with NResponseType::Pong response
+ * Over SOCK_SEQPACKET socket each frame is a single packet.
+ */
+constexpr uint8_t requestCode = 0x52;
 constexpr uint8_t dissmisCode = 0xDE;
 constexpr uint8_t ackCode = 0xAC;
+constexpr uint8_t pingCode = 0x50;
+
+// Requests sent to notification daemon without waiting for responses
+constexpr std::size_t requestWindow = 4;
+// Queued requests of one package sent together, to be answered in one popup.
+// Group never takes more than room left in requestWindow.
+constexpr std::size_t requestGroupLimit = 16;
 
 } // namespace Protocol
 } // namespace AskUser
@@ -37,13 +37,16 @@ const Cynara::PolicyType ASK_USER = 10;
 namespace Client {
 const Cynara::PolicyType ALLOW_ONCE = 11;
 const Cynara::PolicyType ALLOW_PER_SESSION = 12;
-// This one will never reach client, but will be interpreted in service plugin
+// Cached by service plugin, client plugin reuses it in every session
 const Cynara::PolicyType ALLOW_PER_LIFE = 13;
 
 const Cynara::PolicyType DENY_ONCE = 14;
 const Cynara::PolicyType DENY_PER_SESSION = 15;
-// This one will never reach client, but will be interpreted in service plugin
+// Cached by service plugin, client plugin reuses it in every session
 const Cynara::PolicyType DENY_PER_LIFE = 16;
+
+// Expiry is passed in metadata, see types/TimedPolicy.h
+const Cynara::PolicyType ALLOW_TIMED = 17;
 } //namespace Client
 
 } //namespace SupportedTypes
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        TimedPolicy.cpp
+ * @brief       Definition of time bounded policies expiry functions
+ */
+
+#include "TimedPolicy.h"
+
+#include <cstdio>
+#include <time.h>
+
+#include <exception/ErrnoException.h>
+
+namespace AskUser {
+namespace TimedPolicy {
+
+Clock::time_point Clock::now() {
+    timespec ts;
+    if (clock_gettime(CLOCK_BOOTTIME, &ts) == -1)
+        throw ErrnoException("Reading boot time clock failed");
+    return time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+}
+
+std::string expiryToMetadata(Clock::time_point expiry) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(expiry.time_since_epoch());
+    return std::to_string(ms.count());
+}
+
+bool metadataToExpiry(const std::string &metadata, Clock::time_point &expiry) {
+    long long ms;
+    int consumed = 0;
+
+    if (sscanf(metadata.c_str(), "%lld%n", &ms, &consumed) != 1
+        || static_cast<std::size_t>(consumed) != metadata.size() || ms < 0) {
+        return false;
+    }
+
+    expiry = Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::milliseconds(ms)));
+    return true;
+}
+
+bool isExpired(const std::string &metadata, Clock::time_point now) {
+    Clock::time_point expiry;
+    // Malformed expiry never grants anything
+    if (!metadataToExpiry(metadata, expiry))
+        return true;
+    return now >= expiry;
+}
+
+} // namespace TimedPolicy
+} // namespace AskUser
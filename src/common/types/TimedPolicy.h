@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        TimedPolicy.h
+ * @brief       Expiry of time bounded policies passed in policy metadata
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace AskUser {
+namespace TimedPolicy {
+
+/*
+ * CLOCK_BOOTTIME is shared by all processes, so expiry can be checked by cynara clients.
+ * Unlike steady_clock it keeps running while device is suspended, so allowed time is not
+ * prolonged by sleep.
+ */
+struct Clock {
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<Clock> time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now();
+};
+
+constexpr std::chrono::minutes AllowDuration(15);
+
+std::string expiryToMetadata(Clock::time_point expiry);
+bool metadataToExpiry(const std::string &metadata, Clock::time_point &expiry);
+bool isExpired(const std::string &metadata, Clock::time_point now = Clock::now());
+
+} // namespace TimedPolicy
+} // namespace AskUser
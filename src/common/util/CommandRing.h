@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        CommandRing.h
+ * @brief       Bounded lock-free queue passing commands to a single consumer thread
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace AskUser {
+namespace Util {
+
+/*
+ * Ring of cells, each with its own sequence number telling whether it is free for producer
+ * or filled for consumer. Any thread may push, pop is meant for the owning thread only.
+ * Neither of them blocks: push fails when ring is full, pop when it is empty.
+ */
+template <class T>
+class CommandRing {
+public:
+    explicit CommandRing(std::size_t capacity);
+
+    CommandRing(const CommandRing &) = delete;
+    CommandRing &operator=(const CommandRing &) = delete;
+
+    bool push(T &&value);
+    bool pop(T &value);
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUp(std::size_t capacity);
+
+    const std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // Producers and consumer update different cache lines
+    alignas(64) std::atomic<std::size_t> m_pushPos;
+    alignas(64) std::atomic<std::size_t> m_popPos;
+};
+
+template <class T>
+CommandRing<T>::CommandRing(std::size_t capacity)
+    : m_mask(roundUp(capacity) - 1), m_cells(new Cell[m_mask + 1]), m_pushPos(0), m_popPos(0)
+{
+    for (std::size_t i = 0; i <= m_mask; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <class T>
+std::size_t CommandRing<T>::roundUp(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    return size;
+}
+
+template <class T>
+bool CommandRing<T>::push(T &&value) {
+    std::size_t pos = m_pushPos.load(std::memory_order_relaxed);
+    Cell *cell;
+
+    for (;;) {
+        cell = &m_cells[pos & m_mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+        if (diff == 0) {
+            if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = m_pushPos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <class T>
+bool CommandRing<T>::pop(T &value) {
+    std::size_t pos = m_popPos.load(std::memory_order_relaxed);
+    Cell *cell = &m_cells[pos & m_mask];
+    std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+    if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1) < 0)
+        return false;
+
+    m_popPos.store(pos + 1, std::memory_order_relaxed);
+    value = std::move(cell->value);
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace Util
+} // namespace AskUser
@@ -27,6 +27,7 @@
 #include <log/log.h>
 #include <types/PolicyDescription.h>
 #include <types/SupportedTypes.h>
+#include <types/TimedPolicy.h>
 
 using namespace Cynara;
 
@@ -34,9 +35,12 @@ namespace AskUser {
 const std::vector<PolicyDescription> clientDescriptions = {
         { SupportedTypes::Client::ALLOW_ONCE, "Allow once" },
         { SupportedTypes::Client::ALLOW_PER_SESSION, "Allow per session" },
+        { SupportedTypes::Client::ALLOW_PER_LIFE, "Allow per life" },
+        { SupportedTypes::Client::ALLOW_TIMED, "Allow for limited time" },
 
         { SupportedTypes::Client::DENY_ONCE, "Deny once" },
-        { SupportedTypes::Client::DENY_PER_SESSION, "Deny per session" }
+        { SupportedTypes::Client::DENY_PER_SESSION, "Deny per session" },
+        { SupportedTypes::Client::DENY_PER_LIFE, "Deny per life" }
 };
 
 class ClientPlugin : public ClientPluginInterface {
@@ -47,7 +51,10 @@ public:
 
     bool isCacheable(const ClientSession &session UNUSED, const PolicyResult &result) {
         return (result.policyType() == SupportedTypes::Client::ALLOW_PER_SESSION
-                || result.policyType() == SupportedTypes::Client::DENY_PER_SESSION);
+                || result.policyType() == SupportedTypes::Client::DENY_PER_SESSION
+                || result.policyType() == SupportedTypes::Client::ALLOW_PER_LIFE
+                || result.policyType() == SupportedTypes::Client::DENY_PER_LIFE
+                || result.policyType() == SupportedTypes::Client::ALLOW_TIMED);
     }
 
     bool isUsable(const ClientSession &session,
@@ -66,6 +73,15 @@ public:
             LOGD("Previous session <" << prevSession << "> does not match current session <"
                     << session << ">");
             return false;
+        // Decision stays until cynara invalidates cache, whatever session asks
+        case SupportedTypes::Client::ALLOW_PER_LIFE:
+        case SupportedTypes::Client::DENY_PER_LIFE:
+            return true;
+        case SupportedTypes::Client::ALLOW_TIMED:
+            if (!TimedPolicy::isExpired(result.metadata()))
+                return true;
+            LOGD("Timed policy expired <" << result.metadata() << ">");
+            return false;
         default:
             return false;
         }
@@ -77,7 +93,11 @@ public:
         switch (result.policyType()) {
             case SupportedTypes::Client::ALLOW_ONCE:
             case SupportedTypes::Client::ALLOW_PER_SESSION:
+            case SupportedTypes::Client::ALLOW_PER_LIFE:
                 return CYNARA_API_ACCESS_ALLOWED;
+            case SupportedTypes::Client::ALLOW_TIMED:
+                return TimedPolicy::isExpired(result.metadata()) ? CYNARA_API_ACCESS_DENIED
+                                                                 : CYNARA_API_ACCESS_ALLOWED;
             default:
                 return CYNARA_API_ACCESS_DENIED;
         }
@@ -32,39 +32,68 @@
 
 namespace Plugin {
 
-template<class Key, class Value>
+constexpr std::size_t hashCombine(std::size_t seed, std::size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+template<class Key>
+struct KeyHash : public std::hash<Key> {};
+
+template<class... Members>
+struct KeyHash<std::tuple<Members...>> {
+    std::size_t operator()(const std::tuple<Members...> &key) const {
+        return combine<0>(key, 0);
+    }
+
+private:
+    template<std::size_t N>
+    static typename std::enable_if<N == sizeof...(Members), std::size_t>::type
+    combine(const std::tuple<Members...> &, std::size_t seed) {
+        return seed;
+    }
+
+    template<std::size_t N>
+    static typename std::enable_if<N < sizeof...(Members), std::size_t>::type
+    combine(const std::tuple<Members...> &key, std::size_t seed) {
+        typedef typename std::tuple_element<N, std::tuple<Members...>>::type Member;
+        return combine<N + 1>(key, hashCombine(seed, std::hash<Member>()(std::get<N>(key))));
+    }
+};
+
+template<class Key, class Value, class Hash = KeyHash<Key>, class KeyEqual = std::equal_to<Key>>
 class CapacityCache {
 public:
-    //using KeyHasherFun = std::function<std::string(const Key &)>;
-    typedef std::function<std::string(const Key &)> KeyHasherFun;
     static const std::size_t CACHE_DEFAULT_CAPACITY = 100;
 
-    CapacityCache(const std::function<std::string(const Key&)> &func,
-                  std::size_t capacity = CACHE_DEFAULT_CAPACITY)
+    CapacityCache(std::size_t capacity = CACHE_DEFAULT_CAPACITY,
+                  const Hash &hash = Hash(),
+                  const KeyEqual &equal = KeyEqual())
         : m_capacity(capacity),
-          m_keyHasher(func)
+          m_keyValue(0, hash, equal)
     {}
 
     bool get(const Key &key, Value &value);
     bool update(const Key &key, const Value &value);
+    void remove(const Key &key);
     void clear();
 
 private:
-    typedef std::list<std::string> KeyUsageList;
-    typedef std::unordered_map<std::string, std::pair<Value, KeyUsageList::iterator>> KeyValueMap;
+    // Keys are owned by m_keyValue, whose nodes keep their addresses until erased
+    typedef std::list<const Key *> KeyUsageList;
+    typedef std::unordered_map<Key, std::pair<Value, typename KeyUsageList::iterator>,
+                               Hash, KeyEqual> KeyValueMap;
 
     void evict();
 
     std::size_t m_capacity;
 
-    KeyHasherFun m_keyHasher;
     KeyUsageList m_keyUsage;
     KeyValueMap m_keyValue;
 };
 
-template<class Key, class Value>
-bool CapacityCache<Key, Value>::get(const Key &key, Value &value) {
-    auto resultIt = m_keyValue.find(m_keyHasher(key));
+template<class Key, class Value, class Hash, class KeyEqual>
+bool CapacityCache<Key, Value, Hash, KeyEqual>::get(const Key &key, Value &value) {
+    auto resultIt = m_keyValue.find(key);
     //Do we have entry in cache?
     if (resultIt == m_keyValue.end()) {
         return false;
@@ -78,49 +107,57 @@ bool CapacityCache<Key, Value>::get(const Key &key, Value &value) {
     return true;
 }
 
-template<class Key, class Value>
-void CapacityCache<Key, Value>::clear(void) {
+template<class Key, class Value, class Hash, class KeyEqual>
+void CapacityCache<Key, Value, Hash, KeyEqual>::clear(void) {
     m_keyUsage.clear();
     m_keyValue.clear();
 }
 
-template <class Key, class Value>
-void CapacityCache<Key, Value>::evict(void) {
-    auto lastUsedKey = m_keyUsage.back();
+template<class Key, class Value, class Hash, class KeyEqual>
+void CapacityCache<Key, Value, Hash, KeyEqual>::remove(const Key &key) {
+    auto resultIt = m_keyValue.find(key);
+    if (resultIt == m_keyValue.end())
+        return;
+
+    m_keyUsage.erase(resultIt->second.second);
+    m_keyValue.erase(resultIt);
+}
+
+template<class Key, class Value, class Hash, class KeyEqual>
+void CapacityCache<Key, Value, Hash, KeyEqual>::evict(void) {
+    const Key *lastUsedKey = m_keyUsage.back();
     m_keyUsage.pop_back();
 
-    auto value_it = m_keyValue.find(lastUsedKey);
-    m_keyValue.erase(value_it);
+    m_keyValue.erase(*lastUsedKey);
 }
 
-template <class Key, class Value>
-bool CapacityCache<Key, Value>::update(const Key &key, const Value &value) {
+template<class Key, class Value, class Hash, class KeyEqual>
+bool CapacityCache<Key, Value, Hash, KeyEqual>::update(const Key &key, const Value &value) {
     if (m_capacity == 0) {
         LOGD("Cache size is 0");
         return false;
     }
-    if (m_keyValue.size() == m_capacity) {
-        LOGD("Capacity [" << m_capacity << "] reached");
-        evict();
-    }
-
-    std::string cacheKey = m_keyHasher(key);
 
-    bool existed = false;
-    auto resultIt = m_keyValue.find(cacheKey);
+    auto resultIt = m_keyValue.find(key);
     if (resultIt != m_keyValue.end()) {
-        existed = true;
         auto usageIt = resultIt->second.second;
         m_keyUsage.splice(m_keyUsage.begin(), m_keyUsage, usageIt);
+        resultIt->second.first = value;
         LOGD("Update existing entry key=<" << key << ">" << " with value=<" << value << ">");
-    } else {
-        m_keyUsage.push_front(cacheKey);
-        LOGD("Added new entry key=<" << key << ">" << " and value=<" << value << ">");
+        return true;
     }
 
-    m_keyValue[cacheKey] = std::make_pair(value, m_keyUsage.begin());
-    return existed;
+    if (m_keyValue.size() == m_capacity) {
+        LOGD("Capacity [" << m_capacity << "] reached");
+        evict();
+    }
+
+    resultIt = m_keyValue.insert(std::make_pair(key,
+                    std::make_pair(value, typename KeyUsageList::iterator()))).first;
+    m_keyUsage.push_front(&resultIt->first);
+    resultIt->second.second = m_keyUsage.begin();
+    LOGD("Added new entry key=<" << key << ">" << " and value=<" << value << ">");
+    return false;
 }
 
 } //namespace AskUser
-
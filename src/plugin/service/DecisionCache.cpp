@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        DecisionCache.cpp
+ * @brief       Definition of bitset based per (client, user) decision cache
+ */
+
+#include "DecisionCache.h"
+
+namespace Plugin {
+
+namespace {
+
+const std::size_t BITS_PER_WORD = 64;
+
+} // namespace
+
+PrivilegeIdMap::PrivilegeId PrivilegeIdMap::intern(const std::string &privilege) {
+    auto it = m_ids.find(privilege);
+    if (it != m_ids.end())
+        return it->second;
+
+    PrivilegeId id = m_ids.size();
+    m_ids.insert(std::make_pair(privilege, id));
+    return id;
+}
+
+bool PrivilegeIdMap::find(const std::string &privilege, PrivilegeId &id) const {
+    auto it = m_ids.find(privilege);
+    if (it == m_ids.end())
+        return false;
+
+    id = it->second;
+    return true;
+}
+
+void PrivilegeIdMap::clear() {
+    m_ids.clear();
+}
+
+DecisionCache::Decision DecisionCache::get(const std::string &client, const std::string &user,
+                                           const std::string &privilege)
+{
+    PrivilegeIdMap::PrivilegeId id;
+    if (!m_privilegeIds.find(privilege, id))
+        return Decision::NONE;
+
+    auto recordIt = m_records.find(makeKey(client, user));
+    if (recordIt == m_records.end())
+        return Decision::NONE;
+
+    Record &record = recordIt->second;
+    m_keyUsage.splice(m_keyUsage.begin(), m_keyUsage, record.usage);
+
+    if (testBit(record.allowed, id))
+        return Decision::ALLOW;
+    if (testBit(record.denied, id))
+        return Decision::DENY;
+    return Decision::NONE;
+}
+
+bool DecisionCache::update(const std::string &client, const std::string &user,
+                           const std::string &privilege, Decision decision)
+{
+    if (m_capacity == 0)
+        return false;
+
+    PrivilegeIdMap::PrivilegeId id = m_privilegeIds.intern(privilege);
+    const std::string &key = makeKey(client, user);
+
+    bool existed = false;
+    auto recordIt = m_records.find(key);
+    if (recordIt != m_records.end()) {
+        Record &record = recordIt->second;
+        existed = testBit(record.allowed, id) || testBit(record.denied, id);
+        m_keyUsage.splice(m_keyUsage.begin(), m_keyUsage, record.usage);
+    } else {
+        if (m_records.size() == m_capacity)
+            evict();
+
+        m_keyUsage.push_front(key);
+        recordIt = m_records.insert(std::make_pair(key, Record())).first;
+        recordIt->second.usage = m_keyUsage.begin();
+    }
+
+    Record &record = recordIt->second;
+    setBit(record.allowed, id, decision == Decision::ALLOW);
+    setBit(record.denied, id, decision == Decision::DENY);
+    return existed;
+}
+
+void DecisionCache::clear() {
+    m_keyUsage.clear();
+    m_records.clear();
+    m_privilegeIds.clear();
+}
+
+const std::string &DecisionCache::makeKey(const std::string &client, const std::string &user) {
+    // Labels and users come from C strings, so they cannot contain the separator
+    m_keyBuffer.assign(client);
+    m_keyBuffer.push_back('\0');
+    m_keyBuffer.append(user);
+    return m_keyBuffer;
+}
+
+void DecisionCache::evict() {
+    m_records.erase(m_keyUsage.back());
+    m_keyUsage.pop_back();
+}
+
+bool DecisionCache::testBit(const Bitset &bitset, PrivilegeIdMap::PrivilegeId id) {
+    std::size_t word = id / BITS_PER_WORD;
+    if (word >= bitset.size())
+        return false;
+    return (bitset[word] >> (id % BITS_PER_WORD)) & 1;
+}
+
+void DecisionCache::setBit(Bitset &bitset, PrivilegeIdMap::PrivilegeId id, bool value) {
+    std::size_t word = id / BITS_PER_WORD;
+    if (word >= bitset.size()) {
+        if (!value)
+            return;
+        bitset.resize(word + 1, 0);
+    }
+
+    uint64_t mask = uint64_t(1) << (id % BITS_PER_WORD);
+    if (value)
+        bitset[word] |= mask;
+    else
+        bitset[word] &= ~mask;
+}
+
+} // namespace Plugin
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        DecisionCache.h
+ * @brief       Declaration of bitset based per (client, user) decision cache
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Plugin {
+
+/*
+ * Maps privilege names to dense, stable identifiers. Identifiers are assigned in order of first
+ * appearance, so they can be used directly as bit positions.
+ */
+class PrivilegeIdMap {
+public:
+    typedef std::size_t PrivilegeId;
+
+    PrivilegeId intern(const std::string &privilege);
+    bool find(const std::string &privilege, PrivilegeId &id) const;
+    std::size_t size() const {
+        return m_ids.size();
+    }
+    void clear();
+
+private:
+    std::unordered_map<std::string, PrivilegeId> m_ids;
+};
+
+/*
+ * LRU cache of per life decisions. One record is kept per (client, user) pair, holding two
+ * bitsets (allowed and denied) indexed by privilege identifier.
+ */
+class DecisionCache {
+public:
+    enum class Decision {
+        NONE,
+        ALLOW,
+        DENY
+    };
+
+    static const std::size_t CACHE_DEFAULT_CAPACITY = 100;
+
+    DecisionCache(std::size_t capacity = CACHE_DEFAULT_CAPACITY)
+        : m_capacity(capacity)
+    {}
+
+    Decision get(const std::string &client, const std::string &user,
+                 const std::string &privilege);
+    bool update(const std::string &client, const std::string &user,
+                const std::string &privilege, Decision decision);
+    void clear();
+
+    std::size_t size() const {
+        return m_records.size();
+    }
+
+private:
+    typedef std::vector<uint64_t> Bitset;
+    typedef std::list<std::string> KeyUsageList;
+
+    struct Record {
+        Bitset allowed;
+        Bitset denied;
+        KeyUsageList::iterator usage;
+    };
+
+    typedef std::unordered_map<std::string, Record> RecordMap;
+
+    const std::string &makeKey(const std::string &client, const std::string &user);
+    void evict();
+
+    static bool testBit(const Bitset &bitset, PrivilegeIdMap::PrivilegeId id);
+    static void setBit(Bitset &bitset, PrivilegeIdMap::PrivilegeId id, bool value);
+
+    std::size_t m_capacity;
+
+    PrivilegeIdMap m_privilegeIds;
+    KeyUsageList m_keyUsage;
+    RecordMap m_records;
+    std::string m_keyBuffer;
+};
+
+} // namespace Plugin
@@ -0,0 +1,217 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        PreAnswerRules.cpp
+ * @brief       Definition of admin defined rules answering requests without asking user
+ */
+
+#include "PreAnswerRules.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace Plugin {
+
+namespace {
+
+bool parseAnswer(const std::string &str, PreAnswerRules::Answer &answer) {
+    if (str == "allow")
+        answer = PreAnswerRules::Answer::ALLOW;
+    else if (str == "deny")
+        answer = PreAnswerRules::Answer::DENY;
+    else if (str == "ask")
+        answer = PreAnswerRules::Answer::ASK;
+    else
+        return false;
+    return true;
+}
+
+std::size_t literalPrefixLength(const std::string &glob) {
+    std::size_t length = glob.find_first_of("*?");
+    return length == std::string::npos ? glob.size() : length;
+}
+
+bool globMatch(const char *glob, const char *str, std::size_t length) {
+    const char *end = str + length;
+    const char *starGlob = nullptr;
+    const char *starStr = nullptr;
+
+    while (str != end) {
+        if (*glob == '*') {
+            starGlob = ++glob;
+            starStr = str;
+        } else if (*glob != '\0' && (*glob == '?' || *glob == *str)) {
+            ++glob;
+            ++str;
+        } else if (starGlob) {
+            glob = starGlob;
+            str = ++starStr;
+        } else {
+            return false;
+        }
+    }
+
+    while (*glob == '*')
+        ++glob;
+    return *glob == '\0';
+}
+
+bool globMatch(const std::string &glob, const std::string &str) {
+    return globMatch(glob.c_str(), str.data(), str.size());
+}
+
+} // namespace
+
+PreAnswerRules::PreAnswerRules()
+    : m_trie(1)
+{}
+
+bool PreAnswerRules::load(std::istream &input, std::string &error) {
+    std::vector<Rule> rules;
+    std::vector<Node> trie(1);
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::stringstream stream(line);
+        std::string client, answer, rest;
+        Rule rule;
+        if (!(stream >> client >> rule.privilege >> rule.user >> answer) || (stream >> rest)
+            || !parseAnswer(answer, rule.answer)) {
+            error = "malformed rule in line " + std::to_string(lineNumber);
+            return false;
+        }
+
+        std::size_t prefixLength = literalPrefixLength(client);
+        rule.clientSuffix = client.substr(prefixLength);
+        rules.push_back(std::move(rule));
+        insert(trie, client.substr(0, prefixLength), rules.size() - 1);
+    }
+
+    m_rules.swap(rules);
+    m_trie.swap(trie);
+    return true;
+}
+
+void PreAnswerRules::clear() {
+    m_rules.clear();
+    m_trie.assign(1, Node());
+}
+
+void PreAnswerRules::insert(std::vector<Node> &trie, const std::string &prefix,
+                            std::size_t rule)
+{
+    std::size_t node = 0;
+    for (char c : prefix) {
+        auto it = trie[node].children.find(c);
+        if (it == trie[node].children.end()) {
+            trie.push_back(Node());
+            it = trie[node].children.insert(std::make_pair(c, trie.size() - 1)).first;
+        }
+        node = it->second;
+    }
+    trie[node].rules.push_back(rule);
+}
+
+PreAnswerRules::Answer PreAnswerRules::match(const std::string &client, const std::string &user,
+                                             const std::string &privilege) const
+{
+    if (m_rules.empty())
+        return Answer::NONE;
+
+    std::size_t best = m_rules.size();
+    std::size_t node = 0;
+    std::size_t depth = 0;
+
+    while (true) {
+        for (std::size_t index : m_trie[node].rules) {
+            if (index >= best)
+                break;
+
+            const Rule &rule = m_rules[index];
+            if (globMatch(rule.clientSuffix.c_str(), client.data() + depth, client.size() - depth)
+                && globMatch(rule.privilege, privilege) && globMatch(rule.user, user)) {
+                best = index;
+                break;
+            }
+        }
+
+        if (depth == client.size())
+            break;
+
+        auto it = m_trie[node].children.find(client[depth]);
+        if (it == m_trie[node].children.end())
+            break;
+        node = it->second;
+        ++depth;
+    }
+
+    return best == m_rules.size() ? Answer::NONE : m_rules[best].answer;
+}
+
+PreAnswerRulesFile::PreAnswerRulesFile(const std::string &path,
+                                       std::chrono::steady_clock::duration checkInterval)
+    : m_path(path),
+      m_checkInterval(checkInterval),
+      m_lastCheck(std::chrono::steady_clock::now()),
+      m_exists(false)
+{
+    memset(&m_stat, 0, sizeof(m_stat));
+}
+
+bool PreAnswerRulesFile::refresh(std::string &error) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastCheck < m_checkInterval)
+        return false;
+    m_lastCheck = now;
+
+    struct stat current;
+    bool exists = stat(m_path.c_str(), &current) == 0;
+    if (exists == m_exists && (!exists || (current.st_ino == m_stat.st_ino
+                                           && current.st_size == m_stat.st_size
+                                           && current.st_mtim.tv_sec == m_stat.st_mtim.tv_sec
+                                           && current.st_mtim.tv_nsec == m_stat.st_mtim.tv_nsec))) {
+        return false;
+    }
+
+    return reload(error);
+}
+
+bool PreAnswerRulesFile::reload(std::string &error) {
+    m_lastCheck = std::chrono::steady_clock::now();
+
+    std::ifstream input(m_path);
+    m_exists = stat(m_path.c_str(), &m_stat) == 0;
+    if (!m_exists || !input) {
+        m_rules.clear();
+        return true;
+    }
+
+    if (!m_rules.load(input, error)) {
+        error = m_path + ": " + error;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Plugin
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        PreAnswerRules.h
+ * @brief       Declaration of admin defined rules answering requests without asking user
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace Plugin {
+
+/*
+ * Rules file contains one rule per line: "client privilege user answer", where client,
+ * privilege and user are globs ('*' matches any sequence, '?' any single character) and answer
+ * is one of: allow, deny, ask. Empty lines and lines starting with '#' are ignored.
+ * First matching rule wins.
+ *
+ * Rules are indexed by a trie built over literal prefixes of client globs, so matching
+ * walks the client label once and checks full globs only for rules on that path.
+ */
+class PreAnswerRules {
+public:
+    enum class Answer {
+        NONE,
+        ALLOW,
+        DENY,
+        ASK
+    };
+
+    PreAnswerRules();
+
+    /* Replaces rules with parsed ones; on parse error rules are left untouched */
+    bool load(std::istream &input, std::string &error);
+    void clear();
+
+    Answer match(const std::string &client, const std::string &user,
+                 const std::string &privilege) const;
+
+    std::size_t size() const {
+        return m_rules.size();
+    }
+
+private:
+    struct Rule {
+        std::string clientSuffix;
+        std::string privilege;
+        std::string user;
+        Answer answer;
+    };
+
+    struct Node {
+        std::map<char, std::size_t> children;
+        std::vector<std::size_t> rules;
+    };
+
+    void insert(std::vector<Node> &trie, const std::string &prefix, std::size_t rule);
+
+    std::vector<Rule> m_rules;
+    std::vector<Node> m_trie;
+};
+
+/*
+ * Keeps PreAnswerRules in sync with rules file. File is checked for changes at most once per
+ * check interval.
+ */
+class PreAnswerRulesFile {
+public:
+    PreAnswerRulesFile(const std::string &path,
+                       std::chrono::steady_clock::duration checkInterval = std::chrono::seconds(1));
+
+    /* Returns true if rules were reloaded */
+    bool refresh(std::string &error);
+    bool reload(std::string &error);
+
+    const PreAnswerRules &rules() const {
+        return m_rules;
+    }
+
+private:
+    std::string m_path;
+    std::chrono::steady_clock::duration m_checkInterval;
+    std::chrono::steady_clock::time_point m_lastCheck;
+    bool m_exists;
+    struct stat m_stat;
+
+    PreAnswerRules m_rules;
+};
+
+} // namespace Plugin
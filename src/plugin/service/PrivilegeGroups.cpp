@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        PrivilegeGroups.cpp
+ * @brief       Definition of privilege to privilege group mapping
+ */
+
+#include "PrivilegeGroups.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Plugin {
+
+namespace {
+
+// Privileges are URIs, so group keys with this prefix never collide with them
+const std::string GROUP_KEY_PREFIX = "group:";
+
+} // namespace
+
+bool PrivilegeGroups::load(const std::string &path) {
+    std::ifstream input(path);
+    if (!input)
+        return false;
+
+    load(input);
+    return true;
+}
+
+void PrivilegeGroups::load(std::istream &input) {
+    std::string line;
+
+    m_groupKeys.clear();
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::stringstream stream(line);
+        std::string privilege, group;
+        if (!(stream >> privilege >> group))
+            continue;
+
+        m_groupKeys[privilege] = GROUP_KEY_PREFIX + group;
+    }
+}
+
+void PrivilegeGroups::clear() {
+    m_groupKeys.clear();
+}
+
+const std::string &PrivilegeGroups::cacheKey(const std::string &privilege) const {
+    auto it = m_groupKeys.find(privilege);
+    return it == m_groupKeys.end() ? privilege : it->second;
+}
+
+} // namespace Plugin
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        PrivilegeGroups.h
+ * @brief       Declaration of privilege to privilege group mapping
+ */
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+
+namespace Plugin {
+
+/*
+ * Optional mapping of privileges to groups. A per life decision taken for one privilege of
+ * a group is cached under the group key, so it covers every privilege of that group.
+ *
+ * Mapping file contains one "privilege group" pair per line. Empty lines and lines starting
+ * with '#' are ignored.
+ */
+class PrivilegeGroups {
+public:
+    bool load(const std::string &path);
+    void load(std::istream &input);
+    void clear();
+
+    /* Returns key under which decision for privilege is cached */
+    const std::string &cacheKey(const std::string &privilege) const;
+
+    std::size_t size() const {
+        return m_groupKeys.size();
+    }
+
+private:
+    std::unordered_map<std::string, std::string> m_groupKeys;
+};
+
+} // namespace Plugin
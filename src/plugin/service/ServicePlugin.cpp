@@ -19,25 +19,32 @@
  * @brief       Implementation of cynara server side AskUser plugin.
  */
 
+#include <memory>
 #include <string>
 #include <tuple>
 #include <iostream>
 #include <ostream>
 #include <cynara-plugin.h>
 
+#include <config/Path.h>
 #include <types/PolicyDescription.h>
 #include <types/SupportedTypes.h>
+#include <types/TimedPolicy.h>
 #include <translator/Translator.h>
 
 #include "CapacityCache.h"
+#include "DecisionCache.h"
+#include "PreAnswerRules.h"
+#include "PrivilegeGroups.h"
 
 using namespace Cynara;
 
-typedef std::tuple<std::string, std::string, std::string> Key;
+// Privilege, or its group, is identified by its id interned in PrivilegeIdMap
+typedef std::tuple<std::string, std::string, Plugin::PrivilegeIdMap::PrivilegeId> Key;
 std::ostream &operator<<(std::ostream &os, const Key &key) {
     os << "client: " << std::get<0>(key)
        << ", user: " << std::get<1>(key)
-       << ", privilege: " << std::get<2>(key);
+       << ", privilege id: " << std::get<2>(key);
     return os;
 }
 
@@ -49,17 +56,6 @@ std::ostream &operator<<(std::ostream &os, const PolicyResult &result) {
 
 namespace AskUser {
 
-std::function<std::string(const Key&)> hasher = [](const Key &key) {
-    const char separator = '\1';
-    const auto &client = std::get<0>(key);
-    const auto &user = std::get<1>(key);
-    const auto &privilege = std::get<2>(key);
-    return client + user + privilege + separator +
-            std::to_string(client.size()) + separator +
-            std::to_string(user.size()) + separator +
-            std::to_string(privilege.size());
-};
-
 const std::vector<PolicyDescription> serviceDescriptions = {
     { SupportedTypes::Service::ASK_USER, "Ask user" }
 };
@@ -67,8 +63,11 @@ const std::vector<PolicyDescription> serviceDescriptions = {
 class AskUserPlugin : public ServicePluginInterface {
 public:
     AskUserPlugin()
-        : m_cache(hasher)
-    {}
+        : m_rulesFile(Path::getPreAnswerRulesPath())
+    {
+        loadPrivilegeGroups();
+        reloadRules();
+    }
     const std::vector<PolicyDescription> &getSupportedPolicyDescr() {
         return serviceDescriptions;
     }
@@ -81,16 +80,32 @@ public:
                        PluginData &pluginData) noexcept
     {
         try {
-            if (!m_cache.get(Key(client, user, privilege), result)) {
-                pluginData = Translator::Plugin::requestToData(client, user, privilege);
-                requiredAgent = AgentType(SupportedTypes::Agent::AgentType);
-                return PluginStatus::ANSWER_NOTREADY;
+            refreshRules();
+
+            // Privilege without id has no decision cached
+            Key key(client, user, 0);
+            if (m_privilegeIds.find(m_groups.cacheKey(privilege), std::get<2>(key))
+                && m_cache.get(key, result)) {
+                if (!isExpired(result))
+                    return PluginStatus::ANSWER_READY;
+                LOGD("Timed policy for " << key << " expired");
+                m_cache.remove(key);
             }
-            if (result.policyType() == SupportedTypes::Client::ALLOW_PER_LIFE)
+
+            switch (m_rulesFile.rules().match(client, user, privilege)) {
+            case Plugin::PreAnswerRules::Answer::ALLOW:
                 result = PolicyResult(PredefinedPolicyType::ALLOW);
-            else
+                return PluginStatus::ANSWER_READY;
+            case Plugin::PreAnswerRules::Answer::DENY:
                 result = PolicyResult(PredefinedPolicyType::DENY);
-            return PluginStatus::ANSWER_READY;
+                return PluginStatus::ANSWER_READY;
+            default:
+                break;
+            }
+
+            pluginData = Translator::Plugin::requestToData(client, user, privilege);
+            requiredAgent = AgentType(SupportedTypes::Agent::AgentType);
+            return PluginStatus::ANSWER_NOTREADY;
         } catch (const Translator::TranslateErrorException &e) {
             LOGE("Error translating request to data : " << e.what());
         } catch (const std::exception &e) {
@@ -111,12 +126,14 @@ public:
             PolicyType resultType = Translator::Plugin::dataToAnswer(agentData);
             result = PolicyResult(resultType);
 
-            if (resultType == SupportedTypes::Client::ALLOW_PER_LIFE) {
-                m_cache.update(Key(client, user, privilege), PolicyResult(resultType));
-                result = PolicyResult(PredefinedPolicyType::ALLOW);
-            } else if (resultType == SupportedTypes::Client::DENY_PER_LIFE) {
-                m_cache.update(Key(client, user, privilege), PolicyResult(resultType));
-                result = PolicyResult(PredefinedPolicyType::DENY);
+            if (resultType == SupportedTypes::Client::ALLOW_PER_LIFE
+                || resultType == SupportedTypes::Client::DENY_PER_LIFE) {
+                // Client plugin keeps them for the whole life of the process
+                m_cache.update(decisionKey(client, user, privilege), result);
+            } else if (resultType == SupportedTypes::Client::ALLOW_TIMED) {
+                auto expiry = TimedPolicy::Clock::now() + TimedPolicy::AllowDuration;
+                result = PolicyResult(resultType, TimedPolicy::expiryToMetadata(expiry));
+                m_cache.update(decisionKey(client, user, privilege), result);
             }
 
             return PluginStatus::SUCCESS;
@@ -131,11 +148,59 @@ public:
     }
 
     void invalidate() {
-        m_cache.clear();
+        clearDecisions();
+        loadPrivilegeGroups();
+        reloadRules();
     }
 
 private:
+    void refreshRules() {
+        std::string error;
+        if (m_rulesFile.refresh(error)) {
+            LOGD("Pre-answer rules reloaded: " << m_rulesFile.rules().size() << " rule(s)");
+            // Decisions cached under previous rules could be shadowed by new ones
+            clearDecisions();
+        } else if (!error.empty()) {
+            LOGE("Keeping previous pre-answer rules: " << error);
+        }
+    }
+
+    // Timed policies are dropped lazily, when found expired
+    static bool isExpired(const PolicyResult &result) {
+        return result.policyType() == SupportedTypes::Client::ALLOW_TIMED
+               && TimedPolicy::isExpired(result.metadata());
+    }
+
+    void clearDecisions() {
+        m_cache.clear();
+        // Privilege ids are only needed by cached decisions
+        m_privilegeIds.clear();
+    }
+
+    Key decisionKey(const std::string &client, const std::string &user,
+                    const std::string &privilege) {
+        return Key(client, user, m_privilegeIds.intern(m_groups.cacheKey(privilege)));
+    }
+
+    void reloadRules() {
+        std::string error;
+        if (!m_rulesFile.reload(error))
+            LOGE("Keeping previous pre-answer rules: " << error);
+    }
+
+    void loadPrivilegeGroups() {
+        if (!m_groups.load(Path::getPrivilegeGroupsPath())) {
+            LOGD("No privilege groups loaded from " << Path::getPrivilegeGroupsPath());
+            m_groups.clear();
+            return;
+        }
+        LOGD("Loaded " << m_groups.size() << " grouped privileges");
+    }
+
     Plugin::CapacityCache<Key, PolicyResult> m_cache;
+    Plugin::PrivilegeGroups m_groups;
+    Plugin::PrivilegeIdMap m_privilegeIds;
+    Plugin::PreAnswerRulesFile m_rulesFile;
 };
 
 } // namespace AskUser
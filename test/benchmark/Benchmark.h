@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        Benchmark.h
+ * @brief       Minimal benchmark registry and timing helpers
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+namespace AskUser {
+namespace Benchmark {
+
+typedef std::function<void()> BenchmarkFun;
+typedef std::function<int()> HelperFun;
+typedef std::function<bool()> CountedFun;
+
+class Registrar {
+public:
+    Registrar(const std::string &name, BenchmarkFun fun);
+};
+
+/* Helper process is this binary started again, running only the named helper */
+class HelperRegistrar {
+public:
+    HelperRegistrar(const std::string &name, HelperFun fun);
+};
+
+int runAll(const std::string &filter);
+int runHelper(const std::string &name);
+/* Returns pid of started helper or -1 */
+pid_t spawnHelper(const std::string &name);
+
+void report(const std::string &name, std::size_t operations,
+            std::chrono::steady_clock::duration elapsed);
+void reportMemory(const std::string &name, std::size_t bytes);
+void reportNote(const std::string &name, const std::string &note);
+/* Negative count is reported as not available */
+void reportSyscalls(const std::string &name, std::size_t operations, long syscalls);
+
+/*
+ * Runs fun in forked child traced by this process and returns number of syscalls made by all
+ * threads of the child, libraries included. Returns -1 if it could not be traced or fun failed.
+ * Tracing slows the child down a lot, so it is run apart from measure().
+ */
+long countSyscalls(const CountedFun &fun);
+
+/* Bytes currently allocated through global operator new */
+std::size_t allocatedBytes();
+
+template <typename Fun>
+void measure(const std::string &name, std::size_t operations, Fun fun) {
+    auto start = std::chrono::steady_clock::now();
+    fun();
+    report(name, operations, std::chrono::steady_clock::now() - start);
+}
+
+} // namespace Benchmark
+} // namespace AskUser
+
+#define ASKUSER_BENCHMARK_CONCAT_(a, b) a##b
+#define ASKUSER_BENCHMARK_CONCAT(a, b) ASKUSER_BENCHMARK_CONCAT_(a, b)
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static AskUser::Benchmark::Registrar ASKUSER_BENCHMARK_CONCAT(name, _registrar)(#name, name); \
+    static void name()
+
+#define BENCHMARK_HELPER(name) \
+    static int name(); \
+    static AskUser::Benchmark::HelperRegistrar \
+        ASKUSER_BENCHMARK_CONCAT(name, _registrar)(#name, name); \
+    static int name()
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        activation.cpp
+ * @brief       Notification daemon started on demand, from startDaemon to first answer
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+#include <NotificationTalker.h>
+#include <config/Path.h>
+#include <socket/Socket.h>
+#include <translator/Translator.h>
+#include <types/Protocol.h>
+
+#include "Benchmark.h"
+
+using namespace AskUser::Benchmark;
+using namespace AskUser::Agent;
+using namespace AskUser;
+
+namespace {
+
+const std::size_t COLD_STARTS = 50;
+const auto ANSWER_TIMEOUT = std::chrono::seconds(5);
+
+/*
+ * Talker starting stub daemon process instead of askuser-notification service, so that
+ * process start-up and connection up to first answer is what the cold path adds.
+ * EFL initialization is not included, askuser-notification logs it with "Popup initialized".
+ */
+class Talker : public NotificationTalker {
+public:
+    Talker() : m_answered(0), m_spawnFailed(false) {
+        m_responseHandler = [this](NotificationResponse response) {
+            m_answered = response.id;
+        };
+    }
+
+    bool waitAnswer(RequestId id) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_answered != id && !m_spawnFailed) {
+            if (std::chrono::steady_clock::now() - start > ANSWER_TIMEOUT)
+                return false;
+            std::this_thread::yield();
+        }
+        return !m_spawnFailed;
+    }
+
+    std::chrono::steady_clock::duration startedToAccepted() {
+        return m_startedToAccepted;
+    }
+
+    std::vector<pid_t> daemons() {
+        return m_daemons;
+    }
+
+protected:
+    // Daemons are started one at a time, so accepted connection is the last started one
+    std::string connectionUser(int) {
+        m_startedToAccepted += std::chrono::steady_clock::now() - m_started;
+        return m_user;
+    }
+
+    void startDaemon(const std::string &user, bool) {
+        m_user = user;
+        m_started = std::chrono::steady_clock::now();
+        pid_t pid = spawnHelper("stubDaemon");
+        if (pid == -1)
+            m_spawnFailed = true;
+        else
+            m_daemons.push_back(pid);
+    }
+
+private:
+    std::atomic<RequestId> m_answered;
+    std::atomic<bool> m_spawnFailed;
+
+    // Used by talker thread only, read after requests are answered
+    std::string m_user;
+    std::chrono::steady_clock::time_point m_started;
+    std::chrono::steady_clock::duration m_startedToAccepted{0};
+    std::vector<pid_t> m_daemons;
+};
+
+} // namespace
+
+// Answers every request it gets until askuserd closes connection
+BENCHMARK_HELPER(stubDaemon) {
+    int fd = Socket::connect(Path::getSocketPath());
+    std::string frame;
+
+    for (;;) {
+        Socket::FrameSize size;
+        if (!Socket::recv(fd, &size, sizeof(size)))
+            break;
+        frame.assign(size, '\0');
+        if (!size || !Socket::recv(fd, &frame[0], size))
+            break;
+        if (static_cast<uint8_t>(frame[0]) != Protocol::requestCode)
+            continue;
+
+        for (auto &request : Translator::Gui::dataToNotificationRequests(frame.substr(1))) {
+            struct {
+                Socket::FrameSize size;
+                NotificationResponse response;
+            } __attribute__((packed)) answer = {sizeof(NotificationResponse),
+                                                {request.id, NResponseType::Deny}};
+            if (!Socket::send(fd, &answer, sizeof(answer)))
+                break;
+        }
+    }
+
+    Socket::close(fd);
+    return 0;
+}
+
+BENCHMARK(notificationActivation) {
+    std::vector<pid_t> daemons;
+    bool failed = false;
+
+    {
+        Talker talker;
+        failed = talker.isFailed();
+
+        // Every request comes from other user, so each of them starts its own daemon
+        measure("cold start and first answer", COLD_STARTS, [&]() {
+            for (RequestId id = 1; !failed && id <= COLD_STARTS; ++id) {
+                talker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(id, "client", "user" + std::to_string(id),
+                                                        "privilege"));
+                failed = !talker.waitAnswer(id);
+            }
+        });
+
+        if (!failed)
+            report("startDaemon until connection accepted", COLD_STARTS,
+                   talker.startedToAccepted());
+        daemons = talker.daemons();
+    }
+
+    // Stub daemons end once talker closes their connections
+    for (pid_t pid : daemons)
+        waitpid(pid, nullptr, 0);
+
+    if (failed)
+        reportNote("cold start and first answer", "failed");
+}
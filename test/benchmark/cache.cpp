@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        cache.cpp
+ * @brief       Benchmarks of service plugin decision caches
+ */
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <cynara-plugin.h>
+
+#include <types/SupportedTypes.h>
+
+#include "Benchmark.h"
+
+using namespace Cynara;
+
+namespace {
+
+typedef std::tuple<std::string, std::string, std::string> Key;
+
+} // namespace
+
+std::ostream &operator<<(std::ostream &os, const Key &key) {
+    return os << std::get<0>(key) << " " << std::get<1>(key) << " " << std::get<2>(key);
+}
+
+std::ostream &operator<<(std::ostream &os, const PolicyResult &result) {
+    return os << result.policyType();
+}
+
+#include <service/CapacityCache.h>
+#include <service/DecisionCache.h>
+
+using namespace AskUser::Benchmark;
+
+namespace {
+
+const std::size_t APPS = 100;
+const std::size_t PRIVILEGES = 32;
+const std::size_t LOOKUPS = 1000000;
+const std::string USER = "5001";
+
+std::vector<std::string> makeNames(const std::string &prefix, std::size_t count) {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < count; ++i)
+        names.push_back(prefix + std::to_string(i));
+    return names;
+}
+
+const std::vector<std::string> &clients() {
+    static std::vector<std::string> names = makeNames("User::App::org.tizen.benchmark", APPS);
+    return names;
+}
+
+const std::vector<std::string> &privileges() {
+    static std::vector<std::string> names = makeNames("http://tizen.org/privilege/benchmark.",
+                                                      PRIVILEGES);
+    return names;
+}
+
+// Hasher used by the service plugin before it was made a template parameter
+typedef std::function<std::size_t(const Key &)> KeyHasherFun;
+
+std::size_t stringKeyHash(const Key &key) {
+    const char separator = '\1';
+    const auto &client = std::get<0>(key);
+    const auto &user = std::get<1>(key);
+    const auto &privilege = std::get<2>(key);
+    return std::hash<std::string>()(client + user + privilege + separator +
+            std::to_string(client.size()) + separator +
+            std::to_string(user.size()) + separator +
+            std::to_string(privilege.size()));
+}
+
+template <typename Cache>
+void benchmarkCapacityCache(Cache &cache, std::size_t before) {
+    measure("update", APPS * PRIVILEGES, [&]() {
+        for (auto &client : clients())
+            for (auto &privilege : privileges())
+                cache.update(Key(client, USER, privilege),
+                             PolicyResult(AskUser::SupportedTypes::Client::ALLOW_PER_LIFE));
+    });
+    reportMemory("memory", allocatedBytes() - before);
+
+    std::size_t hits = 0;
+    measure("get", LOOKUPS, [&]() {
+        PolicyResult result;
+        for (std::size_t i = 0; i < LOOKUPS; ++i) {
+            Key key(clients()[i % APPS], USER, privileges()[(i / APPS) % PRIVILEGES]);
+            hits += cache.get(key, result);
+        }
+    });
+    if (hits != LOOKUPS)
+        reportMemory("unexpected misses", LOOKUPS - hits);
+}
+
+} // namespace
+
+BENCHMARK(capacityCache) {
+    std::size_t before = allocatedBytes();
+    Plugin::CapacityCache<Key, PolicyResult> cache(APPS * PRIVILEGES);
+    benchmarkCapacityCache(cache, before);
+}
+
+BENCHMARK(capacityCacheFunctionHasher) {
+    std::size_t before = allocatedBytes();
+    Plugin::CapacityCache<Key, PolicyResult, KeyHasherFun> cache(APPS * PRIVILEGES,
+                                                                 stringKeyHash);
+    benchmarkCapacityCache(cache, before);
+}
+
+BENCHMARK(decisionCache) {
+    std::size_t before = allocatedBytes();
+    Plugin::DecisionCache cache(APPS);
+
+    measure("update", APPS * PRIVILEGES, [&]() {
+        for (auto &client : clients())
+            for (auto &privilege : privileges())
+                cache.update(client, USER, privilege, Plugin::DecisionCache::Decision::ALLOW);
+    });
+    reportMemory("memory", allocatedBytes() - before);
+
+    std::size_t hits = 0;
+    measure("get", LOOKUPS, [&]() {
+        for (std::size_t i = 0; i < LOOKUPS; ++i) {
+            hits += cache.get(clients()[i % APPS], USER, privileges()[(i / APPS) % PRIVILEGES])
+                    != Plugin::DecisionCache::Decision::NONE;
+        }
+    });
+    if (hits != LOOKUPS)
+        reportMemory("unexpected misses", LOOKUPS - hits);
+}
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        main.cpp
+ * @brief       Benchmarks runner
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <malloc.h>
+#include <iostream>
+#include <new>
+#include <spawn.h>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+
+namespace AskUser {
+namespace Benchmark {
+
+namespace {
+
+std::atomic<std::size_t> g_allocated(0);
+
+std::vector<std::pair<std::string, BenchmarkFun>> &registry() {
+    static std::vector<std::pair<std::string, BenchmarkFun>> benchmarks;
+    return benchmarks;
+}
+
+std::vector<std::pair<std::string, HelperFun>> &helpers() {
+    static std::vector<std::pair<std::string, HelperFun>> helpers;
+    return helpers;
+}
+
+const char HELPER_OPTION[] = "--helper";
+
+} // namespace
+
+Registrar::Registrar(const std::string &name, BenchmarkFun fun) {
+    registry().emplace_back(name, std::move(fun));
+}
+
+HelperRegistrar::HelperRegistrar(const std::string &name, HelperFun fun) {
+    helpers().emplace_back(name, std::move(fun));
+}
+
+int runAll(const std::string &filter) {
+    int count = 0;
+    for (auto &benchmark : registry()) {
+        if (benchmark.first.find(filter) == std::string::npos)
+            continue;
+
+        std::cout << "[ " << benchmark.first << " ]" << std::endl;
+        benchmark.second();
+        ++count;
+    }
+    return count;
+}
+
+int runHelper(const std::string &name) {
+    for (auto &helper : helpers()) {
+        if (helper.first == name)
+            return helper.second();
+    }
+
+    std::cerr << "No helper <" << name << ">" << std::endl;
+    return 1;
+}
+
+pid_t spawnHelper(const std::string &name) {
+    const char path[] = "/proc/self/exe";
+    const char *argv[] = {path, HELPER_OPTION, name.c_str(), nullptr};
+
+    pid_t pid;
+    if (posix_spawn(&pid, path, nullptr, nullptr, const_cast<char **>(argv), environ) != 0)
+        return -1;
+    return pid;
+}
+
+void report(const std::string &name, std::size_t operations,
+            std::chrono::steady_clock::duration elapsed)
+{
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    std::cout << "  " << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+              << (operations ? ns / operations : 0.0) << " ns/op"
+              << std::setw(14) << operations << " ops" << std::endl;
+}
+
+void reportMemory(const std::string &name, std::size_t bytes) {
+    std::cout << "  " << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << bytes << " bytes" << std::endl;
+}
+
+void reportNote(const std::string &name, const std::string &note) {
+    std::cout << "  " << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << note << std::endl;
+}
+
+void reportSyscalls(const std::string &name, std::size_t operations, long syscalls) {
+    if (syscalls < 0) {
+        reportNote(name, "n/a");
+        return;
+    }
+
+    std::cout << "  " << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+              << (operations ? static_cast<double>(syscalls) / operations : 0.0)
+              << " syscalls/op" << std::setw(7) << operations << " ops" << std::endl;
+}
+
+std::size_t allocatedBytes() {
+    return g_allocated;
+}
+
+} // namespace Benchmark
+} // namespace AskUser
+
+void *operator new(std::size_t size) {
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+
+    AskUser::Benchmark::g_allocated += malloc_usable_size(ptr);
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    if (!ptr)
+        return;
+
+    AskUser::Benchmark::g_allocated -= malloc_usable_size(ptr);
+    std::free(ptr);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2 && std::string(argv[1]) == AskUser::Benchmark::HELPER_OPTION)
+        return AskUser::Benchmark::runHelper(argv[2]);
+
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    if (AskUser::Benchmark::runAll(filter) == 0) {
+        std::cerr << "No benchmark matches <" << filter << ">" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
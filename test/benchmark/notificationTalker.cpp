@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        notificationTalker.cpp
+ * @brief       Latency of requests passed by agent through NotificationTalker to daemon
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <NotificationTalker.h>
+#include <config/Path.h>
+#include <socket/Socket.h>
+#include <types/Protocol.h>
+
+#include "Benchmark.h"
+
+using namespace AskUser::Benchmark;
+using namespace AskUser::Agent;
+using namespace AskUser;
+
+namespace {
+
+const RequestId REQUESTS = 2000;
+const char USER[] = "user";
+
+// Talker which neither asks cynara about daemon user nor starts the daemon service
+class Talker : public NotificationTalker {
+public:
+    Talker() {
+        m_responseHandler = [](NotificationResponse){};
+    }
+
+protected:
+    std::string connectionUser(int) {
+        return USER;
+    }
+
+    void startDaemon(const std::string &, bool) {}
+};
+
+// Notification daemon side, answering every request it gets
+class Daemon {
+public:
+    Daemon() : m_fd(Socket::connect(Path::getSocketPath())) {}
+    ~Daemon() {
+        Socket::close(m_fd);
+    }
+
+    // Skips acks and pings until next request comes
+    bool nextRequest() {
+        std::string frame;
+        do {
+            Socket::FrameSize size;
+            if (!Socket::recv(m_fd, &size, sizeof(size)))
+                return false;
+            frame.assign(size, '\0');
+            if (!size || !Socket::recv(m_fd, &frame[0], size))
+                return false;
+        } while (static_cast<uint8_t>(frame[0]) != Protocol::requestCode);
+        return true;
+    }
+
+    bool answer(RequestId id) {
+        struct {
+            Socket::FrameSize size;
+            NotificationResponse response;
+        } __attribute__((packed)) frame = {sizeof(NotificationResponse),
+                                           {id, NResponseType::Deny}};
+        return Socket::send(m_fd, &frame, sizeof(frame));
+    }
+
+private:
+    int m_fd;
+};
+
+void addRequest(Talker &talker, RequestId id) {
+    talker.parseRequest(RequestType::RT_Action,
+                        NotificationRequest(id, "client", USER, "privilege"));
+}
+
+} // namespace
+
+BENCHMARK(notificationTalker) {
+    using std::chrono::steady_clock;
+
+    Talker talker;
+    Daemon daemon;
+
+    // First exchange proves connection is accepted
+    addRequest(talker, 0);
+    bool failed = talker.isFailed() || !daemon.nextRequest() || !daemon.answer(0);
+
+    steady_clock::duration worst(0);
+    measure("request sent and answered", REQUESTS, [&]() {
+        for (RequestId id = 1; !failed && id <= REQUESTS; ++id) {
+            auto start = steady_clock::now();
+            addRequest(talker, id);
+            failed = !daemon.nextRequest();
+            worst = std::max(worst, steady_clock::now() - start);
+            failed = failed || !daemon.answer(id);
+        }
+    });
+
+    if (failed) {
+        reportNote("request sent and answered", "failed");
+        return;
+    }
+
+    char note[32];
+    double worstUs = std::chrono::duration<double, std::micro>(worst).count();
+    snprintf(note, sizeof(note), "%.1f us", worstUs);
+    reportNote("worst request from agent to daemon", note);
+}
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        poller.cpp
+ * @brief       Benchmarks of descriptor readiness polling with growing number of connections
+ *
+ * Every way of polling reports time and syscalls of one wakeup, including write which wakes
+ * the connection and read which consumes it. Registration of connections is not counted.
+ */
+
+#include <string>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <socket/Poller.h>
+#include <socket/SelectRead.h>
+
+#include "Benchmark.h"
+
+using namespace AskUser::Benchmark;
+using namespace AskUser::Socket;
+
+namespace {
+
+const std::size_t WAKEUPS = 2000;
+const std::size_t CONNECTIONS[] = {1, 10, 100, 500, 1000, 2000};
+
+/*
+ * Simulated user connections: talker side descriptor and notification daemon side peer.
+ * Only the last connection is active, like a single user answering a popup.
+ */
+struct Connections {
+    Connections(std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1)
+                break;
+            talker.push_back(fds[0]);
+            daemon.push_back(fds[1]);
+        }
+    }
+
+    ~Connections() {
+        for (int fd : talker)
+            ::close(fd);
+        for (int fd : daemon)
+            ::close(fd);
+    }
+
+    bool complete(std::size_t count) const {
+        return talker.size() == count;
+    }
+
+    void wakeLast() {
+        char byte = 0;
+        if (::write(daemon.back(), &byte, 1) != 1)
+            reportNote("write", "failed");
+    }
+
+    void consume(int fd) {
+        char byte;
+        if (::read(fd, &byte, 1) != 1)
+            reportNote("read", "failed");
+    }
+
+    std::vector<int> talker;
+    std::vector<int> daemon;
+};
+
+void raiseDescriptorLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+std::string label(const std::string &name, std::size_t count) {
+    return name + " " + std::to_string(count) + " connections";
+}
+
+// Wakeups are timed, then run again in traced child which counts their syscalls
+void run(const std::string &name, const CountedFun &wakeups) {
+    measure(name, WAKEUPS, [&]() {
+        wakeups();
+    });
+    reportSyscalls(name, WAKEUPS, countSyscalls(wakeups));
+}
+
+/*
+ * Talker loop over persistent registrations. With flushing, each wakeup also watches
+ * writability and stops again, like talker does when socket did not take whole output.
+ */
+void pollConnections(const std::string &name, bool flushing) {
+    for (std::size_t count : CONNECTIONS) {
+        Connections connections(count);
+        Poller poller;
+        if (!connections.complete(count)) {
+            reportNote(label(name, count), "n/a");
+            continue;
+        }
+
+        for (int fd : connections.talker)
+            poller.add(fd);
+
+        run(label(name, count), [&]() {
+            for (std::size_t i = 0; i < WAKEUPS; ++i) {
+                connections.wakeLast();
+                if (flushing)
+                    poller.modify(connections.talker.back(), Poller::Read | Poller::Write);
+                int rv = poller.wait(100);
+                for (int j = 0; j < rv; ++j) {
+                    if (poller.events(j) & Poller::Read)
+                        connections.consume(poller.fd(j));
+                }
+                if (flushing)
+                    poller.modify(connections.talker.back(), Poller::Read);
+            }
+            return true;
+        });
+    }
+}
+
+} // namespace
+
+BENCHMARK(talkerPollSelect) {
+    raiseDescriptorLimit();
+
+    for (std::size_t count : CONNECTIONS) {
+        Connections connections(count);
+        if (!connections.complete(count) || connections.daemon.back() >= FD_SETSIZE) {
+            reportNote(label("SelectRead", count), "n/a");
+            continue;
+        }
+
+        SelectRead select;
+        run(label("SelectRead", count), [&]() {
+            for (std::size_t i = 0; i < WAKEUPS; ++i) {
+                connections.wakeLast();
+                // NotificationTalker rebuilt descriptor set on every iteration
+                for (int fd : connections.talker)
+                    select.add(fd);
+                select.setTimeout(100);
+                int rv = select.exec();
+                for (int fd : connections.talker) {
+                    if (!rv)
+                        break;
+                    if (select.isSet(fd)) {
+                        --rv;
+                        connections.consume(fd);
+                    }
+                }
+            }
+            return true;
+        });
+    }
+}
+
+BENCHMARK(talkerPollEpoll) {
+    raiseDescriptorLimit();
+    pollConnections("Poller", false);
+    pollConnections("Poller flushing", true);
+}
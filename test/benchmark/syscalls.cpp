@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        syscalls.cpp
+ * @brief       Counting of syscalls made by benchmarked code, through ptrace of forked child
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+
+namespace AskUser {
+namespace Benchmark {
+
+namespace {
+
+void killTraced(pid_t pid) {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+} // namespace
+
+long countSyscalls(const CountedFun &fun) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == -1)
+        return -1;
+
+    if (pid == 0) {
+        // Stopped until tracer is attached, so that only fun is counted
+        if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) == -1)
+            _exit(EXIT_FAILURE);
+        raise(SIGSTOP);
+        _exit(fun() ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status;
+    long options = PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL;
+    if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)
+        || ptrace(PTRACE_SETOPTIONS, pid, nullptr, reinterpret_cast<void *>(options)) == -1
+        || ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr) == -1) {
+        killTraced(pid);
+        return -1;
+    }
+
+    // Syscall stops of each thread alternate between entry and exit, entries are counted
+    std::map<pid_t, bool> inSyscall;
+    long syscalls = 0;
+    for (;;) {
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid == -1) {
+            killTraced(pid);
+            return -1;
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            if (tid == pid)
+                return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ? syscalls : -1;
+            inSyscall.erase(tid);
+            continue;
+        }
+
+        long signal = 0;
+        if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+            bool &entered = inSyscall[tid];
+            if (!entered)
+                ++syscalls;
+            entered = !entered;
+        } else if (status >> 16 == 0 && WSTOPSIG(status) != SIGSTOP) {
+            // Signal of the child itself, new threads start with SIGSTOP which is not passed
+            signal = WSTOPSIG(status);
+        }
+        ptrace(PTRACE_SYSCALL, tid, nullptr, reinterpret_cast<void *>(signal));
+    }
+}
+
+} // namespace Benchmark
+} // namespace AskUser
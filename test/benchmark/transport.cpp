@@ -0,0 +1,228 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        transport.cpp
+ * @brief       Time of request and response exchange over askuserd socket types
+ *
+ * Every transport reports time and syscalls of one exchange, syscalls of both peers together.
+ */
+
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include <socket/FramedConnection.h>
+#include <socket/Socket.h>
+
+#include "Benchmark.h"
+
+using namespace AskUser::Benchmark;
+using namespace AskUser;
+using namespace AskUser::Socket;
+
+namespace {
+
+const std::size_t EXCHANGES = 20000;
+// Size of serialized request of typical application and privilege
+const std::size_t REQUEST_SIZE = 120;
+// NotificationResponse
+const std::size_t RESPONSE_SIZE = 8;
+
+struct SocketPair {
+    SocketPair(int type) {
+        if (socketpair(AF_UNIX, type | SOCK_CLOEXEC, 0, fds) == -1)
+            fds[0] = fds[1] = -1;
+    }
+
+    ~SocketPair() {
+        for (int fd : fds)
+            if (fd != -1)
+                ::close(fd);
+    }
+
+    int fds[2];
+};
+
+/*
+ * Exchanges are timed, then run again in traced child which counts their syscalls, so that
+ * calls made inside askuser-common are counted as well.
+ */
+void run(const std::string &name, const CountedFun &exchanges) {
+    bool failed = false;
+    measure(name, EXCHANGES, [&]() {
+        failed = !exchanges();
+    });
+    if (failed) {
+        reportNote(name, "failed");
+        return;
+    }
+    reportSyscalls(name, EXCHANGES, countSyscalls(exchanges));
+}
+
+// Before frames: size_t length prefix read by separate recv, then payload
+void sizePrefixed() {
+    const std::string name = "size prefixed stream";
+    SocketPair pair(SOCK_STREAM);
+    std::string request(REQUEST_SIZE, 'r'), received(REQUEST_SIZE, '\0');
+    std::string response(RESPONSE_SIZE, 'a'), answer(RESPONSE_SIZE, '\0');
+
+    if (pair.fds[0] == -1) {
+        reportNote(name, "failed");
+        return;
+    }
+
+    run(name, [&]() {
+        for (std::size_t i = 0; i < EXCHANGES; ++i) {
+            std::size_t size = request.size();
+            if (!Socket::send(pair.fds[0], &size, sizeof(size))
+                || !Socket::send(pair.fds[0], request.data(), size)
+                || !Socket::recv(pair.fds[1], &size, sizeof(size))
+                || !Socket::recv(pair.fds[1], &received[0], size)
+                || !Socket::send(pair.fds[1], response.data(), response.size())
+                || !Socket::recv(pair.fds[0], &answer[0], answer.size())) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool takeFrame(FramedConnection &connection, std::size_t size) {
+    Frame frame;
+    return connection.receive() && connection.nextFrame(frame) && frame.size == size;
+}
+
+void framed(const std::string &name, int type) {
+    SocketPair pair(type);
+    std::string request(REQUEST_SIZE, 'r'), response(RESPONSE_SIZE, 'a');
+
+    if (pair.fds[0] == -1) {
+        reportNote(name, "failed");
+        return;
+    }
+
+    FramedConnection talker(pair.fds[0]), daemon(pair.fds[1]);
+    run(name, [&]() {
+        for (std::size_t i = 0; i < EXCHANGES; ++i) {
+            if (!talker.send(request.data(), request.size())
+                || !takeFrame(daemon, request.size())
+                || !daemon.send(response.data(), response.size())
+                || !takeFrame(talker, response.size())) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+// Daemon offers rings, both sides switch to them after the handshake through socket
+bool switchToRing(FramedConnection &talker, FramedConnection &daemon) {
+    Frame frame;
+    return daemon.offerRing() && talker.receive() && !talker.nextFrame(frame)
+           && daemon.receive() && !daemon.nextFrame(frame) && talker.receive()
+           && !talker.nextFrame(frame) && talker.bell() != -1;
+}
+
+void sharedRing() {
+    const std::string name = "framed shared ring";
+    SocketPair pair(SOCK_STREAM);
+    std::string request(REQUEST_SIZE, 'r'), response(RESPONSE_SIZE, 'a');
+
+    FramedConnection talker(pair.fds[0]), daemon(pair.fds[1]);
+    if (pair.fds[0] == -1 || !switchToRing(talker, daemon)) {
+        reportNote(name, "failed");
+        return;
+    }
+
+    run(name, [&]() {
+        Frame frame;
+        for (std::size_t i = 0; i < EXCHANGES; ++i) {
+            if (!talker.send(request.data(), request.size())
+                || !daemon.nextFrame(frame) || frame.size != request.size()
+                || !daemon.send(response.data(), response.size())
+                || !talker.nextFrame(frame) || frame.size != response.size()) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+/*
+ * Notification daemon in its own thread, blocked while waiting for request, like the real one.
+ * Wakeups of waiting peer cost syscalls, also with shared rings.
+ */
+void waitingDaemon(const std::string &name, bool ring) {
+    SocketPair pair(SOCK_STREAM);
+    std::string request(REQUEST_SIZE, 'r'), response(RESPONSE_SIZE, 'a');
+
+    FramedConnection talker(pair.fds[0]), daemon(pair.fds[1]);
+    if (pair.fds[0] == -1 || (ring && !switchToRing(talker, daemon))) {
+        reportNote(name, "failed");
+        return;
+    }
+
+    run(name, [&]() {
+        std::thread daemonThread([&]() {
+            Frame request;
+            for (std::size_t i = 0; i < EXCHANGES; ++i) {
+                if (!daemon.waitFrame(request) || !daemon.send(response.data(), response.size())
+                    || !daemon.waitFlushed()) {
+                    break;
+                }
+            }
+        });
+
+        bool failed = false;
+        Frame frame;
+        for (std::size_t i = 0; i < EXCHANGES && !failed; ++i) {
+            failed = !talker.send(request.data(), request.size()) || !talker.waitFlushed()
+                     || !talker.waitFrame(frame) || frame.size != response.size();
+        }
+        // Daemon blocked on failed exchange is released by closing the connection
+        if (failed)
+            shutdown(pair.fds[0], SHUT_RDWR);
+        daemonThread.join();
+        return !failed;
+    });
+}
+
+} // namespace
+
+BENCHMARK(transportSizePrefixed) {
+    sizePrefixed();
+}
+
+BENCHMARK(transportFramedStream) {
+    framed("framed stream", SOCK_STREAM);
+}
+
+BENCHMARK(transportFramedSeqPacket) {
+    framed("framed seqpacket", SOCK_SEQPACKET);
+}
+
+BENCHMARK(transportSharedRing) {
+    sharedRing();
+}
+
+BENCHMARK(transportWaitingStream) {
+    waitingDaemon("framed stream, waiting daemon", false);
+}
+
+BENCHMARK(transportWaitingSharedRing) {
+    waitingDaemon("framed shared ring, waiting daemon", true);
+}
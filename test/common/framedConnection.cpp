@@ -0,0 +1,325 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        framedConnection.cpp
+ * @brief       Tests for FramedConnection class
+ */
+
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <config/Limits.h>
+#include <exception/Exception.h>
+#include <socket/FramedConnection.h>
+#include <socket/Socket.h>
+
+using namespace AskUser::Socket;
+
+namespace {
+
+class FramedConnectionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        open(SOCK_STREAM);
+    }
+
+    void open(int type) {
+        closePeer(0);
+        closePeer(1);
+        ASSERT_EQ(0, socketpair(AF_UNIX, type, 0, m_fds));
+        setNonBlocking(m_fds[0]);
+        setNonBlocking(m_fds[1]);
+        m_sender = FramedConnection(m_fds[0]);
+        m_receiver = FramedConnection(m_fds[1]);
+    }
+
+    void TearDown() override {
+        closePeer(0);
+        closePeer(1);
+    }
+
+    void closePeer(int i) {
+        if (m_fds[i] != -1)
+            ::close(m_fds[i]);
+        m_fds[i] = -1;
+    }
+
+    std::string take() {
+        Frame frame;
+        if (!m_receiver.nextFrame(frame))
+            return "<none>";
+        return std::string(frame.data, frame.size);
+    }
+
+    int m_fds[2] = {-1, -1};
+    FramedConnection m_sender;
+    FramedConnection m_receiver;
+};
+
+} // namespace
+
+/**
+ * @brief   Frames arriving in one read are all taken, head and body form one frame
+ */
+TEST_F(FramedConnectionTest, severalFramesInOneRead) {
+    ASSERT_TRUE(m_sender.send("ab", 2, "cd", 2));
+    ASSERT_TRUE(m_sender.send("e", 1));
+    ASSERT_TRUE(m_sender.send("", 0));
+    ASSERT_FALSE(m_sender.outputPending());
+
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("abcd", take());
+    EXPECT_EQ("e", take());
+    EXPECT_EQ("", take());
+    EXPECT_FALSE(m_receiver.hasFrame());
+}
+
+/**
+ * @brief   Receiving again before whole frames are taken keeps them and makes room for more
+ */
+TEST_F(FramedConnectionTest, receiveBeforeFramesTaken) {
+    // Frames filling the first read of receiver completely
+    std::string first(2000, 'x');
+    std::string second(4096 - 2 * sizeof(FrameSize) - first.size(), 'y');
+    ASSERT_TRUE(m_sender.send(first.data(), first.size()));
+    ASSERT_TRUE(m_sender.send(second.data(), second.size()));
+    ASSERT_TRUE(m_receiver.receive());
+    ASSERT_TRUE(m_receiver.hasFrame());
+
+    ASSERT_TRUE(m_sender.send("next", 4));
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ(first, take());
+    EXPECT_EQ(second, take());
+    EXPECT_EQ("next", take());
+    EXPECT_FALSE(m_receiver.hasFrame());
+}
+
+/**
+ * @brief   Frame delivered byte by byte is complete only after its last byte
+ */
+TEST_F(FramedConnectionTest, frameSplitIntoBytes) {
+    std::string payload = "payload";
+    FrameSize size = payload.size();
+    std::string wire(reinterpret_cast<char *>(&size), sizeof(size));
+    wire += payload;
+
+    for (std::size_t i = 0; i < wire.size(); i++) {
+        EXPECT_FALSE(m_receiver.hasFrame());
+        ASSERT_EQ(1, write(m_fds[0], &wire[i], 1));
+        ASSERT_TRUE(m_receiver.receive());
+    }
+    EXPECT_EQ(payload, take());
+}
+
+/**
+ * @brief   What socket does not take at once is kept until flushed, frames keep their order
+ */
+TEST_F(FramedConnectionTest, partialWriteIsFlushed) {
+    std::string block(4096, 'x');
+    std::size_t sent = 0;
+    while (!m_sender.outputPending()) {
+        block[0] = 'a' + sent % 26;
+        ASSERT_TRUE(m_sender.send(block.data(), block.size()));
+        sent++;
+    }
+    ASSERT_TRUE(m_sender.send("tail", 4));
+    sent++;
+
+    std::size_t received = 0;
+    while (received < sent) {
+        ASSERT_TRUE(m_sender.flush());
+        ASSERT_TRUE(m_receiver.receive());
+        Frame frame;
+        while (m_receiver.nextFrame(frame)) {
+            if (received + 1 == sent) {
+                EXPECT_EQ("tail", std::string(frame.data, frame.size));
+            } else {
+                ASSERT_EQ(block.size(), frame.size);
+                EXPECT_EQ(static_cast<char>('a' + received % 26), frame.data[0]);
+            }
+            received++;
+        }
+    }
+    EXPECT_FALSE(m_sender.outputPending());
+}
+
+/**
+ * @brief   Over seqpacket socket each receive takes one whole frame, queued frames stay separate
+ */
+TEST_F(FramedConnectionTest, seqPacketFrames) {
+    open(SOCK_SEQPACKET);
+
+    std::string block(4096, 'x');
+    std::size_t sent = 0;
+    while (!m_sender.outputPending()) {
+        block[0] = 'a' + sent % 26;
+        ASSERT_TRUE(m_sender.send(block.data(), block.size()));
+        sent++;
+    }
+    ASSERT_TRUE(m_sender.send("tail", 4));
+    sent++;
+
+    std::size_t received = 0;
+    while (received < sent) {
+        ASSERT_TRUE(m_sender.flush());
+        ASSERT_TRUE(m_receiver.receive());
+        Frame frame;
+        if (!m_receiver.nextFrame(frame))
+            continue;
+        if (received + 1 == sent) {
+            EXPECT_EQ("tail", std::string(frame.data, frame.size));
+        } else {
+            ASSERT_EQ(block.size(), frame.size);
+            EXPECT_EQ(static_cast<char>('a' + received % 26), frame.data[0]);
+        }
+        received++;
+        EXPECT_FALSE(m_receiver.hasFrame());
+    }
+    EXPECT_FALSE(m_sender.outputPending());
+}
+
+/**
+ * @brief   Closed peer is reported on both sides
+ */
+TEST_F(FramedConnectionTest, peerClosed) {
+    closePeer(1);
+    EXPECT_FALSE(m_sender.send("a", 1));
+
+    Frame frame;
+    m_receiver = FramedConnection(m_fds[0]);
+    EXPECT_FALSE(m_receiver.waitFrame(frame));
+}
+
+/**
+ * @brief   Frame above size limit is neither sent nor accepted
+ */
+TEST_F(FramedConnectionTest, oversizedFrame) {
+    std::string body(AskUser::Limits::getSizeLimit(), 'x');
+    EXPECT_THROW(m_sender.send("h", 1, body.data(), body.size()), AskUser::Exception);
+    EXPECT_FALSE(m_sender.outputPending());
+
+    FrameSize size = AskUser::Limits::getSizeLimit() + 1;
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(size)), ::write(m_fds[0], &size, sizeof(size)));
+    ASSERT_TRUE(m_receiver.receive());
+    Frame frame;
+    EXPECT_THROW(m_receiver.nextFrame(frame), AskUser::Exception);
+}
+
+/**
+ * @brief   After offer is accepted frames go through shared rings, earlier ones keep their order
+ */
+TEST_F(FramedConnectionTest, sharedRingFrames) {
+    ASSERT_TRUE(m_sender.offerRing());
+    ASSERT_NE(-1, m_sender.bell());
+    ASSERT_TRUE(m_sender.send("early", 5));
+
+    // Descriptors end the read they arrive with
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("<none>", take());
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("early", take());
+    EXPECT_NE(-1, m_receiver.bell());
+    ASSERT_TRUE(m_receiver.send("ring", 4));
+
+    ASSERT_TRUE(m_sender.receive());
+    Frame frame;
+    ASSERT_TRUE(m_sender.nextFrame(frame));
+    EXPECT_EQ("ring", std::string(frame.data, frame.size));
+
+    ASSERT_TRUE(m_sender.send("back", 4));
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("back", take());
+
+    // Nothing goes through socket anymore
+    ASSERT_TRUE(m_receiver.send("more", 4));
+    char byte;
+    EXPECT_EQ(-1, ::recv(m_fds[0], &byte, 1, MSG_DONTWAIT));
+    ASSERT_TRUE(m_sender.nextFrame(frame));
+    EXPECT_EQ("more", std::string(frame.data, frame.size));
+}
+
+/**
+ * @brief   Full ring keeps frames until consumer releases room and rings the producer bell
+ */
+TEST_F(FramedConnectionTest, sharedRingFull) {
+    ASSERT_TRUE(m_sender.offerRing());
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("<none>", take());
+    ASSERT_TRUE(m_sender.receive());
+    Frame frame;
+    ASSERT_FALSE(m_sender.nextFrame(frame));
+
+    std::string block(3000, 'x');
+    std::size_t sent = 0;
+    while (!m_sender.outputPending()) {
+        block[0] = 'a' + sent % 26;
+        ASSERT_TRUE(m_sender.send(block.data(), block.size()));
+        sent++;
+    }
+    ASSERT_GT(sent, 10u);
+    for (std::size_t i = 0; i < 50; i++) {
+        block[0] = 'a' + sent % 26;
+        ASSERT_TRUE(m_sender.send(block.data(), block.size()));
+        sent++;
+    }
+
+    std::size_t received = 0;
+    ASSERT_TRUE(m_receiver.receive());
+    while (received < sent) {
+        while (m_receiver.nextFrame(frame)) {
+            ASSERT_EQ(block.size(), frame.size);
+            EXPECT_EQ(static_cast<char>('a' + received % 26), frame.data[0]);
+            received++;
+        }
+        if (received == sent)
+            break;
+
+        pollfd pfd = {m_sender.bell(), POLLIN, 0};
+        ASSERT_EQ(1, poll(&pfd, 1, 1000));
+        m_sender.clearBell();
+        ASSERT_TRUE(m_sender.flush());
+    }
+    EXPECT_FALSE(m_sender.outputPending());
+}
+
+/**
+ * @brief   Memory which peer could shrink is not accepted, connection stays on socket
+ */
+TEST_F(FramedConnectionTest, sharedRingNeedsSealedMemory) {
+    std::vector<int> fds = {memfd_create("fake", MFD_CLOEXEC), eventfd(0, EFD_CLOEXEC),
+                            eventfd(0, EFD_CLOEXEC)};
+    ASSERT_EQ(0, ftruncate(fds[0], 1 << 20));
+    FrameSize offer = 0xFFFFFFFF;
+    iovec iov = {&offer, sizeof(offer)};
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(offer)), trySend(m_fds[0], &iov, 1, &fds));
+    for (int fd : fds)
+        ::close(fd);
+
+    ASSERT_TRUE(m_sender.send("plain", 5));
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("<none>", take());
+    ASSERT_TRUE(m_receiver.receive());
+    EXPECT_EQ("plain", take());
+    EXPECT_EQ(-1, m_receiver.bell());
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+/**
+ * @file        label.cpp
+ * @brief       Tests for cynara client labels normalization
+ */
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <label/Label.h>
+
+using namespace AskUser;
+
+TEST(Label, appId) {
+    ASSERT_EQ("org.tizen.camera", Label::appId("User::App::org.tizen.camera"));
+    ASSERT_EQ("org.tizen.camera", Label::appId("org.tizen.camera"));
+    ASSERT_EQ("User::Pkg::org.tizen.camera", Label::appId("User::Pkg::org.tizen.camera"));
+}
+
+namespace {
+
+// Application "org.tizen.camera" belongs to package "camera-pkg", "camera-pkg" is not an app
+bool resolve(const std::string &appId, std::string &pkgId) {
+    if (appId != "org.tizen.camera")
+        return false;
+    pkgId = "camera-pkg";
+    return true;
+}
+
+} // namespace
+
+TEST(Label, packageLabelsShareKey) {
+    std::string key = Label::packageKey("User::App::org.tizen.camera", resolve);
+
+    ASSERT_EQ("User::Pkg::camera-pkg", key);
+    ASSERT_EQ(key, Label::packageKey("User::Pkg::camera-pkg", resolve));
+}
+
+TEST(Label, namespacesDoNotShareKey) {
+    std::string key = Label::packageKey("User::App::org.tizen.camera", resolve);
+
+    // Bare labels and application ids equal to package ids are not the package
+    ASSERT_NE(key, Label::packageKey("camera-pkg", resolve));
+    ASSERT_NE(key, Label::packageKey("org.tizen.camera", resolve));
+    ASSERT_NE(key, Label::packageKey("User::App::camera-pkg", resolve));
+    ASSERT_NE(key, Label::packageKey("User::Pkg::camera-pkg::RO", resolve));
+}
+
+TEST(Label, otherLabelsAreKept) {
+    ASSERT_EQ("System", Label::packageKey("System", resolve));
+    ASSERT_EQ("User", Label::packageKey("User", resolve));
+    ASSERT_EQ("org.tizen.camera", Label::packageKey("org.tizen.camera", resolve));
+    ASSERT_EQ("User::Pkg::camera-pkg::RO", Label::packageKey("User::Pkg::camera-pkg::RO", resolve));
+    // Application unknown to security-manager is not mapped anywhere
+    ASSERT_EQ("User::App::org.tizen.unknown", Label::packageKey("User::App::org.tizen.unknown",
+                                                                resolve));
+}
@@ -0,0 +1,242 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        poller.cpp
+ * @brief       Tests for Poller class
+ */
+
+#include <chrono>
+#include <functional>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <socket/Poller.h>
+
+using namespace AskUser::Socket;
+
+namespace {
+
+class PollerTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        closePair();
+    }
+
+    void openPair() {
+        closePair();
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, m_fds));
+    }
+
+    void closePair() {
+        for (int &fd : m_fds) {
+            if (fd != -1)
+                ::close(fd);
+            fd = -1;
+        }
+    }
+
+    void wake() {
+        ASSERT_EQ(1, ::write(m_fds[1], "x", 1));
+    }
+
+    void consume() {
+        char byte;
+        ASSERT_EQ(1, ::read(m_fds[0], &byte, 1));
+    }
+
+    void withPoller(const std::function<void(Poller &)> &check) {
+        openPair();
+        Poller poller(8);
+        check(poller);
+    }
+
+    int m_fds[2] = {-1, -1};
+};
+
+} // namespace
+
+/**
+ * @brief   Readable descriptor is reported, others are not
+ */
+TEST_F(PollerTest, readyDescriptorReported) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        EXPECT_EQ(0, poller.wait(0));
+
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_EQ(m_fds[0], poller.fd(0));
+        EXPECT_TRUE(poller.events(0) & Poller::Read);
+        EXPECT_FALSE(poller.events(0) & Poller::Write);
+    });
+}
+
+/**
+ * @brief   Level-triggered descriptor is reported by every wait until it is read
+ */
+TEST_F(PollerTest, levelTriggeredReportedAgain) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_EQ(m_fds[0], poller.fd(0));
+
+        consume();
+        EXPECT_EQ(0, poller.wait(0));
+    });
+}
+
+/**
+ * @brief   Edge-triggered descriptor is reported once for each arrival of data
+ */
+TEST_F(PollerTest, edgeTriggeredReportedOnce) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0], Poller::Read | Poller::EdgeTriggered);
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_EQ(0, poller.wait(0));
+
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_EQ(m_fds[0], poller.fd(0));
+    });
+}
+
+/**
+ * @brief   Modified registration reports new events only
+ */
+TEST_F(PollerTest, modifyChangesEvents) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        EXPECT_EQ(0, poller.wait(0));
+
+        poller.modify(m_fds[0], Poller::Read | Poller::Write);
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_TRUE(poller.events(0) & Poller::Write);
+
+        poller.modify(m_fds[0], Poller::Read);
+        EXPECT_EQ(0, poller.wait(0));
+        EXPECT_THROW(poller.modify(m_fds[1], Poller::Read), std::exception);
+    });
+}
+
+/**
+ * @brief   Removed descriptor is not reported, even if its number is taken by another one
+ */
+TEST_F(PollerTest, removedNotReported) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        poller.remove(m_fds[0]);
+        poller.remove(m_fds[1]);
+        wake();
+        EXPECT_EQ(0, poller.wait(0));
+
+        int reused = m_fds[0];
+        closePair();
+        openPair();
+        ASSERT_EQ(reused, m_fds[0]);
+        poller.add(m_fds[0]);
+        EXPECT_EQ(0, poller.wait(0));
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_EQ(m_fds[0], poller.fd(0));
+    });
+}
+
+/**
+ * @brief   Closed peer is reported even if no events are watched
+ */
+TEST_F(PollerTest, hangupReported) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0], 0);
+        ::close(m_fds[1]);
+        m_fds[1] = -1;
+        ASSERT_EQ(1, poller.wait(1000));
+        EXPECT_TRUE(poller.events(0) & Poller::Hangup);
+    });
+}
+
+/**
+ * @brief   Wait without ready descriptors does not block past timeout
+ */
+TEST_F(PollerTest, timeout) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ(0, poller.wait(30));
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    });
+}
+
+/**
+ * @brief   Events of descriptor removed while batch is handled do not reach its successor
+ */
+TEST_F(PollerTest, removedDuringBatchNotReported) {
+    withPoller([this](Poller &poller) {
+        poller.add(m_fds[0]);
+        wake();
+        ASSERT_EQ(1, poller.wait(1000));
+
+        int reused = m_fds[0];
+        poller.remove(m_fds[0]);
+        closePair();
+        openPair();
+        ASSERT_EQ(reused, m_fds[0]);
+        poller.add(m_fds[0]);
+
+        EXPECT_EQ(-1, poller.fd(0));
+        EXPECT_EQ(0u, poller.events(0));
+    });
+}
+
+/**
+ * @brief   More ready descriptors than one wait reports are reported by following waits
+ */
+TEST_F(PollerTest, manyAddedBeforeWait) {
+    const int count = 64;
+
+    withPoller([&](Poller &poller) {
+        std::vector<int> fds;
+        for (int i = 0; i < count; ++i) {
+            int pair[2];
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair));
+            ASSERT_EQ(1, ::write(pair[1], "x", 1));
+            fds.push_back(pair[0]);
+            fds.push_back(pair[1]);
+            poller.add(pair[0]);
+        }
+
+        // Every one of them is reported, each read empties it
+        int reported = 0;
+        for (int waits = 0; reported < count && waits < count; ++waits) {
+            int ready = poller.wait(1000);
+            for (int i = 0; i < ready; ++i) {
+                char byte;
+                ASSERT_EQ(1, ::read(poller.fd(i), &byte, 1));
+                ++reported;
+            }
+        }
+        EXPECT_EQ(count, reported);
+
+        for (int fd : fds)
+            ::close(fd);
+    });
+}
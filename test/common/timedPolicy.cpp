@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+/**
+ * @file        timedPolicy.cpp
+ * @brief       Tests for expiry of time bounded policies
+ */
+
+#include <chrono>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <types/TimedPolicy.h>
+
+using namespace AskUser::TimedPolicy;
+
+TEST(TimedPolicy, roundTrip) {
+    Clock::time_point expiry = Clock::now() + AllowDuration;
+    Clock::time_point parsed;
+
+    ASSERT_TRUE(metadataToExpiry(expiryToMetadata(expiry), parsed));
+    ASSERT_EQ(std::chrono::duration_cast<std::chrono::milliseconds>(expiry.time_since_epoch()),
+              std::chrono::duration_cast<std::chrono::milliseconds>(parsed.time_since_epoch()));
+}
+
+TEST(TimedPolicy, expiry) {
+    Clock::time_point now = Clock::now();
+    std::string metadata = expiryToMetadata(now + std::chrono::minutes(1));
+
+    ASSERT_FALSE(isExpired(metadata, now));
+    ASSERT_TRUE(isExpired(metadata, now + std::chrono::minutes(1)));
+    ASSERT_TRUE(isExpired(expiryToMetadata(now - std::chrono::seconds(1)), now));
+}
+
+TEST(TimedPolicy, clockCountsSuspendTime) {
+    // Boot time is monotonic time plus time spent in suspend, so it is never behind it
+    auto monotonic = std::chrono::steady_clock::now().time_since_epoch();
+    auto boot = Clock::now().time_since_epoch();
+
+    ASSERT_GE(std::chrono::duration_cast<std::chrono::nanoseconds>(boot),
+              std::chrono::duration_cast<std::chrono::nanoseconds>(monotonic));
+}
+
+TEST(TimedPolicy, malformedMetadataIsExpired) {
+    Clock::time_point now = Clock::now();
+
+    ASSERT_TRUE(isExpired("", now));
+    ASSERT_TRUE(isExpired("soon", now));
+    ASSERT_TRUE(isExpired("123abc", now));
+    ASSERT_TRUE(isExpired("-5", now));
+}
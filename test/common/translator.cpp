@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -54,3 +55,80 @@ TEST(TranslatorTest, NotificationRequest) {
     ASSERT_EQ(app, request.data.client);
     ASSERT_EQ(privilege, request.data.privilege);
 }
+
+TEST(TranslatorTest, NotificationRequests) {
+    std::vector<NotificationRequest> requests = {
+        {1, "lorem ipsum dolor est amet", "user", "http://example.com/permissions/first"},
+        {7, "lorem ipsum dolor est amet", "user", "http://example.com/permissions/second"},
+        {12, "lorem ipsum dolor est amet", "user", ""},
+    };
+
+    auto data = Translator::Gui::notificationRequestsToData(requests);
+    auto translated = Translator::Gui::dataToNotificationRequests(data);
+
+    ASSERT_EQ(requests.size(), translated.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        ASSERT_EQ(requests[i].id, translated[i].id);
+        ASSERT_EQ(requests[i].data.client, translated[i].data.client);
+        ASSERT_EQ(requests[i].data.privilege, translated[i].data.privilege);
+    }
+}
+
+TEST(TranslatorTest, NotificationRequestsDataSize) {
+    std::vector<NotificationRequest> requests;
+    std::size_t requestsSize = 0;
+    for (RequestId id : {0u, 9u, 10u, 12345u}) {
+        requests.push_back({id, std::string(id % 13, 'c'), "user", std::string(id % 101, 'p')});
+        requestsSize += Translator::Gui::notificationRequestDataSize(requests.back());
+        ASSERT_EQ(Translator::Gui::notificationRequestsToData(requests).size(),
+                  Translator::Gui::notificationRequestsDataSize(requests.size(), requestsSize));
+    }
+
+    std::vector<NotificationRequest> many(12, {1, "app", "user", "priv"});
+    std::size_t manySize = many.size() * Translator::Gui::notificationRequestDataSize(many[0]);
+    ASSERT_EQ(Translator::Gui::notificationRequestsToData(many).size(),
+              Translator::Gui::notificationRequestsDataSize(many.size(), manySize));
+}
+
+TEST(TranslatorTest, NotificationRequestsMalformed) {
+    ASSERT_THROW(Translator::Gui::dataToNotificationRequests("3 1 3 app 4 priv  "),
+                 Translator::TranslateErrorException);
+}
+
+TEST(TranslatorTest, NotificationRequestsReuseStorage) {
+    std::vector<NotificationRequest> requests = {
+        {1, "lorem ipsum dolor est amet", "user", "http://example.com/permissions/first"},
+        {7, "lorem ipsum dolor est amet", "user", "http://example.com/permissions/second"},
+    };
+    auto data = Translator::Gui::notificationRequestsToData(requests);
+
+    std::vector<NotificationRequest> translated;
+    Translator::Gui::dataToNotificationRequests(data.data(), data.size(), translated);
+    ASSERT_EQ(requests.size(), translated.size());
+    const char *client = translated[0].data.client.c_str();
+    const char *privilege = translated[0].data.privilege.c_str();
+
+    std::vector<NotificationRequest> shorter = {{3, "app", "user", "priv"}};
+    data = Translator::Gui::notificationRequestsToData(shorter);
+    Translator::Gui::dataToNotificationRequests(data.data(), data.size(), translated);
+
+    ASSERT_EQ(1u, translated.size());
+    ASSERT_EQ(3u, translated[0].id);
+    ASSERT_EQ("app", translated[0].data.client);
+    ASSERT_EQ("priv", translated[0].data.privilege);
+    ASSERT_EQ(client, translated[0].data.client.c_str());
+    ASSERT_EQ(privilege, translated[0].data.privilege.c_str());
+}
+
+TEST(TranslatorTest, NotificationRequestsBufferMalformed) {
+    std::vector<NotificationRequest> translated;
+    std::string truncated = "1 1 3 app 4 pri";
+    ASSERT_THROW(Translator::Gui::dataToNotificationRequests(truncated.data(), truncated.size(),
+                                                             translated),
+                 Translator::TranslateErrorException);
+
+    std::string tooBigId = "1 99999999999999999999999 3 app 4 priv";
+    ASSERT_THROW(Translator::Gui::dataToNotificationRequests(tooBigId.data(), tooBigId.size(),
+                                                             translated),
+                 Translator::TranslateErrorException);
+}
@@ -19,14 +19,29 @@
  * @brief       Tests for NotificationTalker class
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cynara-creds-socket.h>
 #include <fcntl.h>
 #include <memory>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <NotificationTalker.h>
+#include <config/Limits.h>
+#include <config/Path.h>
+#include <socket/FramedConnection.h>
+#include <socket/Socket.h>
+#include <translator/Translator.h>
+#include <types/Protocol.h>
 
 using namespace AskUser::Agent;
 using namespace AskUser;
@@ -37,22 +52,37 @@ namespace {
 
 class FakeNotificationTalker : public NotificationTalker {
 public:
-    FakeNotificationTalker() {
+    FakeNotificationTalker(Heartbeat heartbeat = Heartbeat(),
+                           Socket::Type socketType = Socket::Type::Stream)
+        : NotificationTalker(heartbeat, socketType) {
         m_responseHandler = [](NotificationResponse){};
     }
 
+    // Counts commands passed to talker thread, so that sync() knows when all of them ran
+    void parseRequest(RequestType type, NotificationRequest request) {
+        if (type == RequestType::RT_Action || type == RequestType::RT_Cancel)
+            ++m_commandsPassed;
+        NotificationTalker::parseRequest(type, std::move(request));
+    }
+
     void addRequest(NotificationRequest &&request) {
         addRequest_(request);
+        ++m_commandsRun;
+    }
+
+    void removeRequest(RequestId id) {
+        removeRequest_(id);
+        ++m_commandsRun;
     }
 
     MOCK_METHOD1(addRequest_, void(NotificationRequest));
-    MOCK_METHOD1(removeRequest, void(RequestId));
+    MOCK_METHOD1(removeRequest_, void(RequestId));
     MOCK_METHOD0(stop, void());
 
     int queueSize() {
         int sum = 0;
         for (auto &pair : m_requests) {
-            sum += std::get<1>(pair).size();
+            sum += pair.second.requests.size() + pair.second.inFlight.size();
         }
         return sum;
     }
@@ -69,9 +99,65 @@ public:
         return m_sockfd;
     }
 
+    // Waits until talker thread has run all commands passed by parseRequest
+    void sync() {
+        while (m_commandsRun != m_commandsPassed)
+            std::this_thread::yield();
+    }
+
     void clear() {
         NotificationTalker::clear();
     }
+
+    // Names users of connections in order of acceptance, instead of asking cynara
+    void nameUsers(std::vector<std::string> users) {
+        m_users = std::move(users);
+    }
+
+    // Kernel rounds size up to its minimum, so little output fills socket
+    void limitSendBuffer(int size) {
+        m_sendBuffer = size;
+    }
+
+    void waitAccepted(std::size_t count) {
+        while (m_accepted < count)
+            std::this_thread::yield();
+    }
+
+    int daemonsStarted() {
+        return m_started;
+    }
+
+    int daemonsRestarted() {
+        return m_restarted;
+    }
+
+protected:
+    std::string connectionUser(int fd) {
+        if (m_sendBuffer)
+            setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &m_sendBuffer, sizeof(m_sendBuffer));
+
+        std::size_t index = m_accepted;
+        std::string user = index < m_users.size() ? m_users[index]
+                                                  : NotificationTalker::connectionUser(fd);
+        ++m_accepted;
+        return user;
+    }
+
+    void startDaemon(const std::string &, bool restart) {
+        ++m_started;
+        if (restart)
+            ++m_restarted;
+    }
+
+private:
+    std::vector<std::string> m_users;
+    int m_sendBuffer = 0;
+    std::atomic<std::size_t> m_commandsPassed{0};
+    std::atomic<std::size_t> m_commandsRun{0};
+    std::atomic<std::size_t> m_accepted{0};
+    std::atomic<int> m_started{0};
+    std::atomic<int> m_restarted{0};
 };
 
 } /* namespace */
@@ -92,6 +178,7 @@ TEST(NotificationTalker, addRequest) {
 
     int requestCountBegin = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Action, ptr);
+    notificationTalker.sync();
     int requestCountEnd = notificationTalker.queueSize();
 
     ASSERT_EQ(requestCountBegin + 1, requestCountEnd);
@@ -112,13 +199,15 @@ TEST(NotificationTalker, addAndRemoveRequest) {
     EXPECT_CALL(notificationTalker, addRequest_(_)).
             WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
 
-    EXPECT_CALL(notificationTalker, removeRequest(id)).
+    EXPECT_CALL(notificationTalker, removeRequest_(id)).
             WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
 
     int requestCountBegin = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Action, ptr);
+    notificationTalker.sync();
     int requestCountAdd = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Cancel, ptr2);
+    notificationTalker.sync();
     int requestCountEnd = notificationTalker.queueSize();
 
     ASSERT_EQ(requestCountBegin + 1, requestCountAdd);
@@ -141,19 +230,59 @@ TEST(NotificationTalker, addAndRemoveNonExistingRequest) {
     EXPECT_CALL(notificationTalker, addRequest_(_)).
             WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
 
-    EXPECT_CALL(notificationTalker, removeRequest(id2)).
+    EXPECT_CALL(notificationTalker, removeRequest_(id2)).
             WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
 
     int requestCountBegin = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Action, ptr);
+    notificationTalker.sync();
     int requestCountAdd = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Cancel, ptr2);
+    notificationTalker.sync();
     int requestCountEnd = notificationTalker.queueSize();
 
     ASSERT_EQ(requestCountBegin + 1, requestCountAdd);
     ASSERT_EQ(requestCountAdd, requestCountEnd);
 }
 
+TEST(NotificationTalker, removeRequestOfLaterUser) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+
+    EXPECT_CALL(notificationTalker, addRequest_(_)).Times(2).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+    EXPECT_CALL(notificationTalker, removeRequest_(_)).
+            WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
+
+    // Users are kept ordered, so "user2" queue is not the first one searched
+    notificationTalker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(1, "client", "user1", "privilege"));
+    notificationTalker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(2, "client", "user2", "privilege"));
+    notificationTalker.parseRequest(RequestType::RT_Cancel, NotificationRequest(2));
+    notificationTalker.sync();
+
+    ASSERT_EQ(1, notificationTalker.queueSize());
+}
+
+TEST(NotificationTalker, addDuplicateRequest) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+
+    EXPECT_CALL(notificationTalker, addRequest_(_)).Times(2).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    notificationTalker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(1, "client", "user1", "privilege"));
+    notificationTalker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(1, "client", "user2", "privilege"));
+    notificationTalker.sync();
+
+    ASSERT_EQ(1, notificationTalker.queueSize());
+}
+
 TEST(NotificationTalker, removeNonExistingRequest) {
     using testing::Invoke;
 
@@ -162,11 +291,12 @@ TEST(NotificationTalker, removeNonExistingRequest) {
 
     NotificationRequest ptr(id);
 
-    EXPECT_CALL(notificationTalker, removeRequest(id)).
+    EXPECT_CALL(notificationTalker, removeRequest_(id)).
             WillOnce(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
 
     int requestCountBegin = notificationTalker.queueSize();
     notificationTalker.parseRequest(RequestType::RT_Cancel, ptr);
+    notificationTalker.sync();
     int requestCountEnd = notificationTalker.queueSize();
 
     ASSERT_EQ(requestCountBegin, requestCountEnd);
@@ -194,3 +324,649 @@ TEST(NotificationTalker, closeSocket) {
 
     ASSERT_EQ(-1, fcntl(fd, F_GETFL));
 }
+
+namespace {
+
+// Plays notification daemon side of the protocol
+class FakeDaemon {
+public:
+    FakeDaemon(Socket::Type type = Socket::Type::Stream)
+        : m_fd(Socket::connect(Path::getSocketPath(), type)) {}
+    ~FakeDaemon() {
+        Socket::close(m_fd);
+    }
+
+    std::string user() {
+        char *user = nullptr;
+        if (cynara_creds_socket_get_user(m_fd, USER_METHOD_DEFAULT, &user) != CYNARA_API_SUCCESS)
+            return "";
+        std::unique_ptr<char[]> userPtr(user);
+        return user;
+    }
+
+    bool readable(int timeoutMs) {
+        pollfd pfd = {m_fd, POLLIN, 0};
+        return poll(&pfd, 1, timeoutMs) == 1;
+    }
+
+    int fd() {
+        return m_fd;
+    }
+
+    Socket::Type type() {
+        return Socket::getType(m_fd);
+    }
+
+    bool recvFrame(std::string &frame) {
+        Socket::FrameSize size;
+        if (type() == Socket::Type::SeqPacket) {
+            // Whole frame has to be taken in one call, rest of packet would be lost
+            std::string packet(1 << 16, '\0');
+            ssize_t result = ::recv(m_fd, &packet[0], packet.size(), 0);
+            if (result < static_cast<ssize_t>(sizeof(size)))
+                return false;
+            memcpy(&size, packet.data(), sizeof(size));
+            frame = packet.substr(sizeof(size), result - sizeof(size));
+            return frame.size() == size;
+        }
+
+        if (!Socket::recv(m_fd, &size, sizeof(size)))
+            return false;
+        frame.assign(size, '\0');
+        return Socket::recv(m_fd, &frame[0], size);
+    }
+
+    bool recvMessage(uint8_t &code, std::vector<RequestId> &ids) {
+        ids.clear();
+        std::string frame;
+        if (!recvFrame(frame) || frame.empty())
+            return false;
+        std::size_t size = frame.size();
+
+        code = static_cast<uint8_t>(frame[0]);
+        if (code == Protocol::pingCode)
+            return true;
+        if (code != Protocol::requestCode) {
+            RequestId id;
+            if (size != sizeof(code) + sizeof(id))
+                return false;
+            memcpy(&id, frame.data() + sizeof(code), sizeof(id));
+            ids.push_back(id);
+            return true;
+        }
+
+        for (auto &request : Translator::Gui::dataToNotificationRequests(frame.substr(sizeof(code))))
+            ids.push_back(request.id);
+        return true;
+    }
+
+    bool answer(RequestId id, NResponseType type = NResponseType::Deny) {
+        struct {
+            Socket::FrameSize size;
+            NotificationResponse response;
+        } __attribute__((packed)) frame = {sizeof(NotificationResponse), {id, type}};
+        return Socket::send(m_fd, &frame, sizeof(frame));
+    }
+
+    bool sendRaw(const void *data, std::size_t size) {
+        return Socket::send(m_fd, data, size);
+    }
+
+    bool closedByPeer(int timeoutMs) {
+        char byte;
+        return readable(timeoutMs) && ::recv(m_fd, &byte, sizeof(byte), MSG_DONTWAIT) == 0;
+    }
+
+    // Skips whatever was sent until end of connection
+    bool waitClosed(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        char buffer[256];
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (!readable(10))
+                continue;
+            ssize_t result = ::recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (result <= 0)
+                return result == 0;
+        }
+        return false;
+    }
+
+private:
+    int m_fd;
+};
+
+void expectMessage(FakeDaemon &daemon, uint8_t code, std::vector<RequestId> ids) {
+    uint8_t receivedCode;
+    std::vector<RequestId> receivedIds;
+    ASSERT_TRUE(daemon.recvMessage(receivedCode, receivedIds));
+    ASSERT_EQ(code, receivedCode);
+    ASSERT_EQ(ids, receivedIds);
+}
+
+void expectMessage(FakeDaemon &daemon, uint8_t code, RequestId id) {
+    expectMessage(daemon, code, std::vector<RequestId>{id});
+}
+
+// Every request comes from other client, so none of them is grouped with another
+void addRequest(FakeNotificationTalker &talker, RequestId id, const std::string &user,
+                const std::string &client = std::string()) {
+    talker.parseRequest(RequestType::RT_Action,
+                        NotificationRequest(id, client.empty() ? "client" + std::to_string(id)
+                                                               : client,
+                                            user, "privilege"));
+}
+
+} /* namespace */
+
+TEST(NotificationTalker, fullRingKeepsCommands) {
+    using testing::Invoke;
+
+    // More commands than ring takes
+    const RequestId count = 3000;
+    std::atomic<bool> entered{false};
+    std::atomic<bool> held{true};
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke([&](NotificationRequest request) {
+                // Talker thread is kept busy with the first request while rest piles up
+                entered = true;
+                while (request.id == 0 && held)
+                    std::this_thread::yield();
+                notificationTalker.invokeAdd(std::move(request));
+            }));
+    EXPECT_CALL(notificationTalker, removeRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
+
+    addRequest(notificationTalker, 0, "user");
+    while (!entered)
+        std::this_thread::yield();
+
+    for (RequestId id = 1; id <= count; ++id)
+        addRequest(notificationTalker, id, "user");
+    for (RequestId id = 2; id <= count; id += 2)
+        notificationTalker.parseRequest(RequestType::RT_Cancel, NotificationRequest(id));
+
+    // Every cancel runs after request it cancels
+    held = false;
+    notificationTalker.sync();
+    ASSERT_EQ(static_cast<int>(1 + count / 2), notificationTalker.queueSize());
+}
+
+TEST(NotificationTalker, requestWindow) {
+    using testing::Invoke;
+
+    const RequestId window = Protocol::requestWindow;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+    EXPECT_CALL(notificationTalker, removeRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
+
+    FakeDaemon daemon;
+    std::string user = daemon.user();
+    ASSERT_FALSE(user.empty());
+
+    for (RequestId id = 1; id <= window + 2; ++id)
+        addRequest(notificationTalker, id, user);
+
+    for (RequestId id = 1; id <= window; ++id)
+        expectMessage(daemon, Protocol::requestCode, id);
+    ASSERT_FALSE(daemon.readable(50));
+
+    // Responses are matched by id, not by order
+    ASSERT_TRUE(daemon.answer(2));
+    expectMessage(daemon, Protocol::ackCode, 2);
+    expectMessage(daemon, Protocol::requestCode, window + 1);
+
+    notificationTalker.parseRequest(RequestType::RT_Cancel, NotificationRequest(1));
+    expectMessage(daemon, Protocol::dissmisCode, 1);
+    expectMessage(daemon, Protocol::requestCode, window + 2);
+
+    // Late answer to dismissed request is ignored
+    ASSERT_TRUE(daemon.answer(1));
+    ASSERT_FALSE(daemon.readable(50));
+
+    notificationTalker.sync();
+    ASSERT_EQ(static_cast<int>(window), notificationTalker.queueSize());
+}
+
+TEST(NotificationTalker, stalledDaemon) {
+    using testing::Invoke;
+
+    // Requests of whole window are more than shrunk socket buffer takes
+    const std::size_t privilegeSize = Limits::getSizeLimit() - 64;
+    const RequestId window = Protocol::requestWindow;
+    const RequestId samples = 10;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    std::atomic<int> responses(0);
+    notificationTalker.setResponseHandler([&responses](NotificationResponse) {
+        ++responses;
+    });
+
+    notificationTalker.limitSendBuffer(1);
+    notificationTalker.nameUsers({"stalled", "served"});
+    FakeDaemon stalled;
+    notificationTalker.waitAccepted(1);
+    FakeDaemon served;
+    notificationTalker.waitAccepted(2);
+
+    for (RequestId id = 1; id <= window; ++id) {
+        notificationTalker.parseRequest(RequestType::RT_Action,
+                                        NotificationRequest(id, "client" + std::to_string(id),
+                                                            "stalled",
+                                                            std::string(privilegeSize, 'p')));
+    }
+
+    // Stalled daemon does not read, other user is served meanwhile
+    for (RequestId id = window + 1; id <= window + samples; ++id) {
+        addRequest(notificationTalker, id, "served");
+        ASSERT_TRUE(served.readable(1000));
+        expectMessage(served, Protocol::requestCode, id);
+        ASSERT_TRUE(served.answer(id));
+        expectMessage(served, Protocol::ackCode, id);
+    }
+    ASSERT_EQ(static_cast<int>(samples), responses);
+
+    // Buffered remainder is delivered once daemon reads again
+    for (RequestId id = 1; id <= window; ++id)
+        expectMessage(stalled, Protocol::requestCode, id);
+    for (RequestId id = 1; id <= window; ++id) {
+        ASSERT_TRUE(stalled.answer(id));
+        expectMessage(stalled, Protocol::ackCode, id);
+    }
+    ASSERT_EQ(static_cast<int>(samples + window), responses);
+}
+
+TEST(NotificationTalker, oversizedFrameDropsConnection) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    notificationTalker.nameUsers({"broken", "served"});
+    FakeDaemon broken;
+    notificationTalker.waitAccepted(1);
+    FakeDaemon served;
+    notificationTalker.waitAccepted(2);
+
+    Socket::FrameSize size = Limits::getSizeLimit() + 1;
+    ASSERT_TRUE(broken.sendRaw(&size, sizeof(size)));
+    ASSERT_TRUE(broken.closedByPeer(1000));
+
+    // Talker loop goes on serving other daemons
+    addRequest(notificationTalker, 1, "served");
+    expectMessage(served, Protocol::requestCode, 1);
+    ASSERT_TRUE(served.answer(1));
+    expectMessage(served, Protocol::ackCode, 1);
+}
+
+TEST(NotificationTalker, oversizedRequestFails) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    std::atomic<RequestId> failed(0);
+    notificationTalker.setResponseHandler([&failed](NotificationResponse response) {
+        if (response.response == NResponseType::Error)
+            failed = response.id;
+    });
+
+    notificationTalker.nameUsers({"user"});
+    FakeDaemon daemon;
+    notificationTalker.waitAccepted(1);
+
+    notificationTalker.parseRequest(RequestType::RT_Action,
+                                    NotificationRequest(1, "client", "user",
+                                                        std::string(Limits::getSizeLimit(), 'p')));
+    addRequest(notificationTalker, 2, "user");
+    // Commands run in order, so first request is refused by now
+    expectMessage(daemon, Protocol::requestCode, 2);
+    ASSERT_EQ(1u, failed);
+}
+
+TEST(NotificationTalker, userConnectionsShareRequests) {
+    using testing::Invoke;
+
+    const RequestId window = Protocol::requestWindow;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    notificationTalker.nameUsers({"user", "user"});
+    FakeDaemon first;
+    notificationTalker.waitAccepted(1);
+    std::unique_ptr<FakeDaemon> second(new FakeDaemon);
+    notificationTalker.waitAccepted(2);
+
+    // Requests are spread over connections, as long as they have room in their windows
+    for (RequestId id = 1; id <= 2 * window + 1; ++id)
+        addRequest(notificationTalker, id, "user");
+
+    std::vector<RequestId> firstIds, secondIds;
+    for (RequestId i = 0; i < window; ++i) {
+        uint8_t code;
+        std::vector<RequestId> ids;
+        ASSERT_TRUE(first.recvMessage(code, ids));
+        firstIds.insert(firstIds.end(), ids.begin(), ids.end());
+        ASSERT_TRUE(second->recvMessage(code, ids));
+        secondIds.insert(secondIds.end(), ids.begin(), ids.end());
+    }
+    ASSERT_EQ((std::vector<RequestId>{1, 3, 5, 7}), firstIds);
+    ASSERT_EQ((std::vector<RequestId>{2, 4, 6, 8}), secondIds);
+    ASSERT_FALSE(first.readable(50));
+
+    // Answer frees slot on the connection which received it
+    ASSERT_TRUE(second->answer(4));
+    expectMessage(*second, Protocol::ackCode, 4);
+    expectMessage(*second, Protocol::requestCode, window * 2 + 1);
+
+    // Requests of closed connection are taken over by the other one
+    second.reset();
+    ASSERT_TRUE(first.answer(3));
+    expectMessage(first, Protocol::ackCode, 3);
+    expectMessage(first, Protocol::requestCode, 2);
+    ASSERT_TRUE(first.answer(1));
+    expectMessage(first, Protocol::ackCode, 1);
+    expectMessage(first, Protocol::requestCode, 6);
+}
+
+TEST(NotificationTalker, requestGroup) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    // Requests wait for notification daemon
+    addRequest(notificationTalker, 1, "user", "app");
+    addRequest(notificationTalker, 2, "user", "other");
+    addRequest(notificationTalker, 3, "user", "app");
+    addRequest(notificationTalker, 4, "user", "app");
+    notificationTalker.sync();
+
+    notificationTalker.nameUsers({"user"});
+    FakeDaemon daemon;
+
+    // Requests of the same client come together, in order they were queued
+    expectMessage(daemon, Protocol::requestCode, {1, 3, 4});
+    expectMessage(daemon, Protocol::requestCode, 2);
+
+    // Each of them is answered separately
+    for (RequestId id : {3, 1, 2, 4}) {
+        ASSERT_TRUE(daemon.answer(id));
+        expectMessage(daemon, Protocol::ackCode, id);
+    }
+
+    notificationTalker.sync();
+    ASSERT_EQ(0, notificationTalker.queueSize());
+}
+
+TEST(NotificationTalker, requestGroupOfPackage) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    // Applications of one package, and one whose package is not known
+    const std::vector<std::pair<std::string, std::string>> clients = {
+        {"User::App::camera", "User::Pkg::media"},
+        {"User::App::unknown", ""},
+        {"User::App::gallery", "User::Pkg::media"},
+    };
+    for (RequestId id = 1; id <= clients.size(); ++id) {
+        NotificationRequest request(id, clients[id - 1].first, "user", "privilege");
+        request.package = clients[id - 1].second;
+        notificationTalker.parseRequest(RequestType::RT_Action, std::move(request));
+    }
+    notificationTalker.sync();
+
+    notificationTalker.nameUsers({"user"});
+    FakeDaemon daemon;
+
+    expectMessage(daemon, Protocol::requestCode, {1, 3});
+    expectMessage(daemon, Protocol::requestCode, 2);
+}
+
+TEST(NotificationTalker, requestGroupFitsWindow) {
+    using testing::Invoke;
+
+    const RequestId window = Protocol::requestWindow;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    addRequest(notificationTalker, 1, "user", "other");
+    for (RequestId id = 2; id <= window + 2; ++id)
+        addRequest(notificationTalker, id, "user", "app");
+    notificationTalker.sync();
+
+    notificationTalker.nameUsers({"user"});
+    FakeDaemon daemon;
+
+    // Group takes only what is left of the window
+    std::vector<RequestId> group;
+    for (RequestId id = 2; id <= window; ++id)
+        group.push_back(id);
+    expectMessage(daemon, Protocol::requestCode, 1);
+    expectMessage(daemon, Protocol::requestCode, group);
+    ASSERT_FALSE(daemon.readable(50));
+
+    ASSERT_TRUE(daemon.answer(1));
+    expectMessage(daemon, Protocol::ackCode, 1);
+    expectMessage(daemon, Protocol::requestCode, window + 1);
+
+    ASSERT_TRUE(daemon.answer(2));
+    expectMessage(daemon, Protocol::ackCode, 2);
+    expectMessage(daemon, Protocol::requestCode, window + 2);
+}
+
+TEST(NotificationTalker, requestGroupFitsFrame) {
+    using testing::Invoke;
+
+    // Two such requests do not fit into one frame together
+    const std::string privilege(Limits::getSizeLimit() / 2, 'p');
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    for (RequestId id = 1; id <= 3; ++id) {
+        notificationTalker.parseRequest(RequestType::RT_Action,
+                                        NotificationRequest(id, "app", "user", privilege));
+    }
+    addRequest(notificationTalker, 4, "user", "app");
+    notificationTalker.sync();
+
+    notificationTalker.nameUsers({"user"});
+    FakeDaemon daemon;
+
+    // Group ends where the next request would not fit, the rest goes in next groups
+    expectMessage(daemon, Protocol::requestCode, 1);
+    expectMessage(daemon, Protocol::requestCode, 2);
+    expectMessage(daemon, Protocol::requestCode, {3, 4});
+}
+
+TEST(NotificationTalker, startDaemonOnDemand) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    // Daemon is started once, not for every request waiting for it
+    addRequest(notificationTalker, 1, "5001");
+    addRequest(notificationTalker, 2, "5001");
+    notificationTalker.sync();
+    ASSERT_EQ(1, notificationTalker.daemonsStarted());
+
+    notificationTalker.nameUsers({"5001", "5001"});
+    std::unique_ptr<FakeDaemon> daemon(new FakeDaemon);
+    expectMessage(*daemon, Protocol::requestCode, 1);
+    expectMessage(*daemon, Protocol::requestCode, 2);
+    ASSERT_TRUE(daemon->answer(1));
+    expectMessage(*daemon, Protocol::ackCode, 1);
+
+    // Daemon exiting with unanswered request is started again
+    daemon.reset();
+    for (int i = 0; i < 100 && notificationTalker.daemonsStarted() < 2; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(2, notificationTalker.daemonsStarted());
+
+    daemon.reset(new FakeDaemon);
+    expectMessage(*daemon, Protocol::requestCode, 2);
+}
+
+TEST(NotificationTalker, stuckDaemonIsDropped) {
+    using testing::Invoke;
+    using std::chrono::milliseconds;
+    using std::chrono::steady_clock;
+
+    const Heartbeat heartbeat(milliseconds(100), milliseconds(100));
+    // Only eviction itself is checked, how soon it comes depends on machine load
+    const milliseconds evictionTimeout(5000);
+
+    FakeNotificationTalker notificationTalker(heartbeat);
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    std::atomic<RequestId> timedOut(0);
+    notificationTalker.setResponseHandler([&timedOut](NotificationResponse response) {
+        if (response.response == NResponseType::None)
+            timedOut = response.id;
+    });
+
+    notificationTalker.nameUsers({"user", "user"});
+    FakeDaemon stuck;
+    notificationTalker.waitAccepted(1);
+
+    addRequest(notificationTalker, 1, "user");
+    addRequest(notificationTalker, 2, "user");
+
+    // Stuck daemon answers nothing, it is dropped and the oldest request times out
+    ASSERT_TRUE(stuck.waitClosed(evictionTimeout));
+    ASSERT_EQ(1u, timedOut);
+
+    // Other request goes to daemon which answers pings
+    FakeDaemon alive;
+    expectMessage(alive, Protocol::requestCode, 2);
+    ASSERT_EQ(1, notificationTalker.daemonsRestarted());
+    int pings = 0;
+    auto served = steady_clock::now();
+    while (steady_clock::now() - served < 5 * (heartbeat.interval + heartbeat.deadline)) {
+        if (!alive.readable(10))
+            continue;
+        expectMessage(alive, Protocol::pingCode, std::vector<RequestId>());
+        ASSERT_TRUE(alive.answer(0, NResponseType::Pong));
+        ++pings;
+    }
+    ASSERT_GT(pings, 0);
+
+    ASSERT_TRUE(alive.answer(2));
+    expectMessage(alive, Protocol::ackCode, 2);
+    ASSERT_EQ(1u, timedOut);
+}
+
+TEST(NotificationTalker, seqPacketSocket) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker(Heartbeat(), Socket::Type::SeqPacket);
+    ASSERT_FALSE(notificationTalker.isFailed());
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+    EXPECT_CALL(notificationTalker, removeRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeRemove));
+
+    FakeDaemon daemon(Socket::Type::SeqPacket);
+    ASSERT_EQ(Socket::Type::SeqPacket, daemon.type());
+    std::string user = daemon.user();
+    ASSERT_FALSE(user.empty());
+
+    addRequest(notificationTalker, 1, user);
+    addRequest(notificationTalker, 2, user);
+    expectMessage(daemon, Protocol::requestCode, 1);
+    expectMessage(daemon, Protocol::requestCode, 2);
+
+    notificationTalker.parseRequest(RequestType::RT_Cancel, NotificationRequest(2));
+    expectMessage(daemon, Protocol::dissmisCode, 2);
+
+    ASSERT_TRUE(daemon.answer(1));
+    expectMessage(daemon, Protocol::ackCode, 1);
+
+    notificationTalker.sync();
+    ASSERT_EQ(0, notificationTalker.queueSize());
+}
+
+TEST(NotificationTalker, seqPacketFallsBackToStream) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    FakeDaemon daemon(Socket::Type::SeqPacket);
+    ASSERT_EQ(Socket::Type::Stream, daemon.type());
+    std::string user = daemon.user();
+    ASSERT_FALSE(user.empty());
+
+    addRequest(notificationTalker, 1, user);
+    expectMessage(daemon, Protocol::requestCode, 1);
+}
+
+TEST(NotificationTalker, sharedRing) {
+    using testing::Invoke;
+
+    FakeNotificationTalker notificationTalker;
+    EXPECT_CALL(notificationTalker, addRequest_(_)).
+            WillRepeatedly(Invoke(&notificationTalker, &FakeNotificationTalker::invokeAdd));
+
+    FakeDaemon daemon;
+    std::string user = daemon.user();
+    ASSERT_FALSE(user.empty());
+
+    Socket::FramedConnection channel(daemon.fd());
+    ASSERT_TRUE(channel.offerRing());
+
+    auto expectFrame = [&](uint8_t code, RequestId id) {
+        Socket::Frame frame;
+        ASSERT_TRUE(channel.waitFrame(frame));
+        ASSERT_LE(sizeof(code), frame.size);
+        ASSERT_EQ(code, static_cast<uint8_t>(frame.data[0]));
+        if (code == Protocol::requestCode) {
+            auto requests = Translator::Gui::dataToNotificationRequests(
+                    std::string(frame.data + 1, frame.size - 1));
+            ASSERT_EQ(1u, requests.size());
+            ASSERT_EQ(id, requests[0].id);
+        }
+    };
+
+    for (RequestId id = 1; id <= 3; ++id) {
+        addRequest(notificationTalker, id, user);
+        expectFrame(Protocol::requestCode, id);
+
+        NotificationResponse response = {id, NResponseType::Deny};
+        ASSERT_TRUE(channel.send(&response, sizeof(response)));
+        ASSERT_TRUE(channel.waitFlushed());
+        expectFrame(Protocol::ackCode, id);
+    }
+
+    // Requests come through ring, nothing is left in socket
+    addRequest(notificationTalker, 4, user);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!channel.hasFrame() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+    ASSERT_TRUE(channel.hasFrame());
+    ASSERT_FALSE(daemon.readable(0));
+    expectFrame(Protocol::requestCode, 4);
+}
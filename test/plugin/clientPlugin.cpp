@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        clientPlugin.cpp
+ * @brief       Tests for reuse of cached results by cynara client side AskUser plugin
+ */
+
+#include <memory>
+
+#include <cynara-client-plugin.h>
+#include <cynara-error.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <types/SupportedTypes.h>
+
+using namespace Cynara;
+using namespace AskUser;
+
+extern "C" ExternalPluginInterface *create(void);
+extern "C" void destroy(ExternalPluginInterface *ptr);
+
+namespace {
+
+const ClientSession session = "session";
+const ClientSession nextSession = "next session";
+
+class ClientPluginTest : public ::testing::Test {
+protected:
+    ClientPluginTest() : m_plugin(create(), &destroy) {}
+
+    ClientPluginInterface &plugin() {
+        return *static_cast<ClientPluginInterface *>(m_plugin.get());
+    }
+
+    // Cached in session, asked for again in given session
+    bool reused(PolicyType type, const ClientSession &askingSession) {
+        PolicyResult result(type);
+        if (!plugin().isCacheable(session, result))
+            return false;
+
+        bool updateSession;
+        return plugin().isUsable(askingSession, session, updateSession, result);
+    }
+
+    int access(PolicyType type) {
+        PolicyResult result(type);
+        return plugin().toResult(session, result);
+    }
+
+private:
+    std::unique_ptr<ExternalPluginInterface, decltype(&destroy)> m_plugin;
+};
+
+} // namespace
+
+TEST_F(ClientPluginTest, perLifeResultIsReusedInEverySession) {
+    for (PolicyType type : {SupportedTypes::Client::ALLOW_PER_LIFE,
+                            SupportedTypes::Client::DENY_PER_LIFE}) {
+        ASSERT_TRUE(reused(type, session));
+        ASSERT_TRUE(reused(type, nextSession));
+    }
+
+    ASSERT_EQ(CYNARA_API_ACCESS_ALLOWED, access(SupportedTypes::Client::ALLOW_PER_LIFE));
+    ASSERT_EQ(CYNARA_API_ACCESS_DENIED, access(SupportedTypes::Client::DENY_PER_LIFE));
+}
+
+TEST_F(ClientPluginTest, perSessionResultIsReusedInItsSessionOnly) {
+    for (PolicyType type : {SupportedTypes::Client::ALLOW_PER_SESSION,
+                            SupportedTypes::Client::DENY_PER_SESSION}) {
+        ASSERT_TRUE(reused(type, session));
+        ASSERT_FALSE(reused(type, nextSession));
+    }
+}
+
+TEST_F(ClientPluginTest, onceResultIsNotReused) {
+    ASSERT_FALSE(reused(SupportedTypes::Client::ALLOW_ONCE, session));
+    ASSERT_FALSE(reused(SupportedTypes::Client::DENY_ONCE, session));
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+/**
+ * @file        decisionCache.cpp
+ * @brief       Tests for DecisionCache class
+ */
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <service/DecisionCache.h>
+
+using namespace Plugin;
+
+namespace {
+
+typedef DecisionCache::Decision Decision;
+
+const std::string client = "User::App::org.tizen.test";
+const std::string user = "5001";
+const std::string privilege = "http://tizen.org/privilege/camera";
+
+} // namespace
+
+TEST(DecisionCache, missOnEmpty) {
+    DecisionCache cache;
+
+    ASSERT_EQ(Decision::NONE, cache.get(client, user, privilege));
+}
+
+TEST(DecisionCache, updateAndGet) {
+    DecisionCache cache;
+
+    ASSERT_FALSE(cache.update(client, user, privilege, Decision::ALLOW));
+    ASSERT_EQ(Decision::ALLOW, cache.get(client, user, privilege));
+    ASSERT_EQ(Decision::NONE, cache.get(client, user, privilege + "2"));
+    ASSERT_EQ(Decision::NONE, cache.get(client, "5002", privilege));
+
+    ASSERT_TRUE(cache.update(client, user, privilege, Decision::DENY));
+    ASSERT_EQ(Decision::DENY, cache.get(client, user, privilege));
+}
+
+TEST(DecisionCache, manyPrivilegesShareRecord) {
+    DecisionCache cache;
+
+    for (int i = 0; i < 200; ++i)
+        cache.update(client, user, privilege + std::to_string(i),
+                     i % 2 ? Decision::DENY : Decision::ALLOW);
+
+    ASSERT_EQ(1u, cache.size());
+    for (int i = 0; i < 200; ++i)
+        ASSERT_EQ(i % 2 ? Decision::DENY : Decision::ALLOW,
+                  cache.get(client, user, privilege + std::to_string(i)));
+}
+
+TEST(DecisionCache, evictLeastRecentlyUsed) {
+    DecisionCache cache(2);
+
+    cache.update("a", user, privilege, Decision::ALLOW);
+    cache.update("b", user, privilege, Decision::ALLOW);
+    cache.get("a", user, privilege);
+    cache.update("c", user, privilege, Decision::ALLOW);
+
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_EQ(Decision::ALLOW, cache.get("a", user, privilege));
+    ASSERT_EQ(Decision::NONE, cache.get("b", user, privilege));
+    ASSERT_EQ(Decision::ALLOW, cache.get("c", user, privilege));
+}
+
+TEST(DecisionCache, clear) {
+    DecisionCache cache;
+
+    cache.update(client, user, privilege, Decision::ALLOW);
+    cache.clear();
+
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_EQ(Decision::NONE, cache.get(client, user, privilege));
+}
+
+TEST(PrivilegeIdMap, privilegesAreInternedUntilClear) {
+    PrivilegeIdMap ids;
+    PrivilegeIdMap::PrivilegeId id;
+
+    ASSERT_FALSE(ids.find(privilege, id));
+    PrivilegeIdMap::PrivilegeId interned = ids.intern(privilege);
+    ASSERT_EQ(0u, interned);
+    ASSERT_TRUE(ids.find(privilege, id));
+    ASSERT_EQ(interned, id);
+    ASSERT_EQ(interned, ids.intern(privilege));
+    ASSERT_EQ(1u, ids.intern("group:media"));
+    ASSERT_EQ(2u, ids.size());
+
+    ids.clear();
+    ASSERT_FALSE(ids.find(privilege, id));
+    ASSERT_EQ(0u, ids.intern("group:media"));
+}
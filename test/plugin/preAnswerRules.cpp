@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+/**
+ * @file        preAnswerRules.cpp
+ * @brief       Tests for PreAnswerRules and PreAnswerRulesFile classes
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <service/PreAnswerRules.h>
+
+using namespace Plugin;
+
+namespace {
+
+typedef PreAnswerRules::Answer Answer;
+
+const std::string camera = "http://tizen.org/privilege/camera";
+const std::string location = "http://tizen.org/privilege/location";
+
+PreAnswerRules makeRules(const std::string &text) {
+    PreAnswerRules rules;
+    std::stringstream input(text);
+    std::string error;
+    EXPECT_TRUE(rules.load(input, error)) << error;
+    return rules;
+}
+
+} // namespace
+
+TEST(PreAnswerRules, noRules) {
+    PreAnswerRules rules;
+
+    ASSERT_EQ(Answer::NONE, rules.match("User::App::a", "5001", camera));
+}
+
+TEST(PreAnswerRules, globs) {
+    auto rules = makeRules("# enterprise apps\n"
+                           "User::App::com.corp.* http://tizen.org/privilege/* * allow\n"
+                           "User::App::org.game? " + camera + " 500? deny\n"
+                           "* " + location + " * ask\n");
+
+    ASSERT_EQ(3u, rules.size());
+    ASSERT_EQ(Answer::ALLOW, rules.match("User::App::com.corp.mail", "5001", camera));
+    ASSERT_EQ(Answer::ALLOW, rules.match("User::App::com.corp.", "5001", location));
+    ASSERT_EQ(Answer::NONE, rules.match("User::App::com.corpX", "5001", camera));
+    ASSERT_EQ(Answer::DENY, rules.match("User::App::org.game1", "5002", camera));
+    ASSERT_EQ(Answer::NONE, rules.match("User::App::org.game12", "5002", camera));
+    ASSERT_EQ(Answer::NONE, rules.match("User::App::org.game1", "6001", camera));
+    ASSERT_EQ(Answer::ASK, rules.match("User::App::org.game1", "5002", location));
+}
+
+TEST(PreAnswerRules, firstMatchingRuleWins) {
+    auto rules = makeRules("User::App::* " + camera + " * deny\n"
+                           "User::App::com.corp.mail " + camera + " * allow\n");
+
+    ASSERT_EQ(Answer::DENY, rules.match("User::App::com.corp.mail", "5001", camera));
+}
+
+TEST(PreAnswerRules, malformedRuleKeepsPreviousRules) {
+    auto rules = makeRules("* * * allow\n");
+    std::stringstream input("* * * sometimes\n");
+    std::string error;
+
+    ASSERT_FALSE(rules.load(input, error));
+    ASSERT_FALSE(error.empty());
+    ASSERT_EQ(Answer::ALLOW, rules.match("User::App::a", "5001", camera));
+}
+
+TEST(PreAnswerRulesFile, hotReload) {
+    std::string path = "/tmp/askuser-tests-rules";
+    std::string error;
+    std::remove(path.c_str());
+
+    PreAnswerRulesFile file(path, std::chrono::seconds(0));
+    ASSERT_TRUE(file.reload(error));
+    ASSERT_EQ(0u, file.rules().size());
+    ASSERT_FALSE(file.refresh(error));
+
+    std::ofstream(path) << "* * * deny\n";
+    ASSERT_TRUE(file.refresh(error));
+    ASSERT_EQ(Answer::DENY, file.rules().match("User::App::a", "5001", camera));
+    ASSERT_FALSE(file.refresh(error));
+
+    std::remove(path.c_str());
+    ASSERT_TRUE(file.refresh(error));
+    ASSERT_EQ(Answer::NONE, file.rules().match("User::App::a", "5001", camera));
+}
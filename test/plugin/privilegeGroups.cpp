@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+/**
+ * @file        privilegeGroups.cpp
+ * @brief       Tests for PrivilegeGroups class
+ */
+
+#include <sstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <service/PrivilegeGroups.h>
+
+using namespace Plugin;
+
+namespace {
+
+const std::string camera = "http://tizen.org/privilege/camera";
+const std::string recorder = "http://tizen.org/privilege/recorder";
+const std::string location = "http://tizen.org/privilege/location";
+
+} // namespace
+
+TEST(PrivilegeGroups, ungroupedPrivilegeIsItsOwnKey) {
+    PrivilegeGroups groups;
+
+    ASSERT_EQ(camera, groups.cacheKey(camera));
+}
+
+TEST(PrivilegeGroups, groupedPrivilegesShareKey) {
+    PrivilegeGroups groups;
+    std::stringstream input("# media\n"
+                            "\n" +
+                            camera + " media\n" +
+                            recorder + "\tmedia\n");
+
+    groups.load(input);
+
+    ASSERT_EQ(2u, groups.size());
+    ASSERT_EQ(groups.cacheKey(camera), groups.cacheKey(recorder));
+    ASSERT_NE(camera, groups.cacheKey(camera));
+    ASSERT_EQ(location, groups.cacheKey(location));
+}
+
+TEST(PrivilegeGroups, missingFile) {
+    PrivilegeGroups groups;
+
+    ASSERT_FALSE(groups.load("/nonexistent/askuser/privilege-groups"));
+}
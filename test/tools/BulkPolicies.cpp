@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        BulkPolicies.cpp
+ * @brief       Definition of bulk import and export of askuser decisions
+ */
+
+#include "BulkPolicies.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <cynara-error.h>
+
+#include <exception/CynaraException.h>
+#include <types/SupportedTypes.h>
+
+namespace AskUser {
+namespace Tools {
+
+namespace {
+
+const char *const ALLOW = "allow";
+const char *const DENY = "deny";
+const char *const ASK = "ask";
+
+int decisionToPolicyType(const std::string &decision) {
+    if (decision == ALLOW)
+        return CYNARA_ADMIN_ALLOW;
+    if (decision == DENY)
+        return CYNARA_ADMIN_DENY;
+    if (decision == ASK)
+        return SupportedTypes::Service::ASK_USER;
+    throw std::invalid_argument("Unknown decision <" + decision + ">");
+}
+
+const char *policyTypeToDecision(int policyType) {
+    switch (policyType) {
+    case CYNARA_ADMIN_ALLOW:
+        return ALLOW;
+    case CYNARA_ADMIN_DENY:
+        return DENY;
+    case SupportedTypes::Service::ASK_USER:
+        return ASK;
+    default:
+        return nullptr;
+    }
+}
+
+void freePolicies(cynara_admin_policy **policies) {
+    if (!policies)
+        return;
+
+    for (cynara_admin_policy **policy = policies; *policy; ++policy) {
+        free((*policy)->bucket);
+        free((*policy)->client);
+        free((*policy)->user);
+        free((*policy)->privilege);
+        free((*policy)->result_extra);
+        free(*policy);
+    }
+    free(policies);
+}
+
+} // namespace
+
+std::vector<DecisionRecord> readRecords(std::istream &input) {
+    std::vector<DecisionRecord> records;
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::stringstream stream(line);
+        std::string decision, rest;
+        DecisionRecord record;
+        if (!(stream >> record.client >> record.user >> record.privilege >> decision)
+            || (stream >> rest)) {
+            throw std::invalid_argument("Malformed record in line " + std::to_string(lineNumber));
+        }
+
+        record.policyType = decisionToPolicyType(decision);
+        records.push_back(std::move(record));
+    }
+
+    return records;
+}
+
+void writeRecords(std::ostream &output, const std::vector<DecisionRecord> &records) {
+    for (auto &record : records) {
+        output << record.client << ' ' << record.user << ' ' << record.privilege << ' '
+               << policyTypeToDecision(record.policyType) << '\n';
+    }
+    output.flush();
+}
+
+void importRecords(cynara_admin *admin, const std::string &bucket,
+                   std::vector<DecisionRecord> &records)
+{
+    std::string bucketName = bucket;
+    std::vector<cynara_admin_policy> policies;
+    std::vector<cynara_admin_policy *> policyPtrs;
+
+    policies.reserve(records.size());
+    policyPtrs.reserve(records.size() + 1);
+
+    for (auto &record : records) {
+        policies.push_back({&bucketName[0], &record.client[0], &record.user[0],
+                            &record.privilege[0], record.policyType, nullptr});
+        policyPtrs.push_back(&policies.back());
+    }
+    policyPtrs.push_back(nullptr);
+
+    int ret = cynara_admin_set_policies(admin, policyPtrs.data());
+    if (ret != CYNARA_API_SUCCESS)
+        throw CynaraException("cynara_admin_set_policies", ret);
+}
+
+std::vector<DecisionRecord> exportRecords(cynara_admin *admin, const std::string &bucket) {
+    cynara_admin_policy **policies = nullptr;
+
+    int ret = cynara_admin_list_policies(admin, bucket.c_str(), CYNARA_ADMIN_ANY,
+                                         CYNARA_ADMIN_ANY, CYNARA_ADMIN_ANY, &policies);
+    if (ret != CYNARA_API_SUCCESS)
+        throw CynaraException("cynara_admin_list_policies", ret);
+
+    std::vector<DecisionRecord> records;
+    try {
+        for (cynara_admin_policy **policy = policies; policy && *policy; ++policy) {
+            if (!policyTypeToDecision((*policy)->result))
+                continue;
+
+            records.push_back({(*policy)->client, (*policy)->user, (*policy)->privilege,
+                               (*policy)->result});
+        }
+    } catch (...) {
+        freePolicies(policies);
+        throw;
+    }
+
+    freePolicies(policies);
+    return records;
+}
+
+} // namespace Tools
+} // namespace AskUser
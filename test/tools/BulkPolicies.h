@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2016 Samsung Electronics Co.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License
+ */
+/**
+ * @file        BulkPolicies.h
+ * @brief       Declaration of bulk import and export of askuser decisions
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cynara-admin.h>
+
+namespace AskUser {
+namespace Tools {
+
+/*
+ * One decision record. Records are stored one per line as whitespace separated
+ * "client user privilege decision", where decision is one of: allow, deny, ask.
+ */
+struct DecisionRecord {
+    std::string client;
+    std::string user;
+    std::string privilege;
+    int policyType;
+};
+
+std::vector<DecisionRecord> readRecords(std::istream &input);
+void writeRecords(std::ostream &output, const std::vector<DecisionRecord> &records);
+
+/* Sets all records with a single cynara_admin_set_policies call */
+void importRecords(cynara_admin *admin, const std::string &bucket,
+                   std::vector<DecisionRecord> &records);
+
+/* Lists all decisions of askuser related types in the bucket */
+std::vector<DecisionRecord> exportRecords(cynara_admin *admin, const std::string &bucket);
+
+} // namespace Tools
+} // namespace AskUser
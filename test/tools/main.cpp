@@ -19,8 +19,12 @@
  * @brief       Main test file
  */
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <cynara-admin.h>
 #include <cynara-client.h>
@@ -31,6 +35,8 @@
 
 #include <unistd.h>
 
+#include "BulkPolicies.h"
+
 cynara *cyn;
 cynara_admin *admin;
 
@@ -40,10 +46,74 @@ void check_cynara_return(std::string func, int ret) {
     }
 }
 
+void print_summary(const std::string &action, std::size_t count,
+                   std::chrono::steady_clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << action << " " << count << " record(s) in " << seconds * 1000 << " ms ("
+              << (seconds > 0 ? count / seconds : 0) << " records/s)" << std::endl;
+}
+
+int bulk(const std::string &mode, const std::string &path, const std::string &bucket)
+{
+    using namespace AskUser::Tools;
+
+    int ret = cynara_admin_initialize(&admin);
+    check_cynara_return("cynara_admin_initialize", ret);
+
+    try {
+        // Summary covers whole transfer, file included
+        auto start = std::chrono::steady_clock::now();
+        if (mode == "--import") {
+            std::ifstream input(path);
+            if (!input)
+                throw std::runtime_error("Could not open <" + path + ">");
+
+            std::vector<DecisionRecord> records = readRecords(input);
+            importRecords(admin, bucket, records);
+            print_summary("Imported", records.size(), std::chrono::steady_clock::now() - start);
+        } else {
+            std::ofstream output(path);
+            if (!output)
+                throw std::runtime_error("Could not open <" + path + ">");
+
+            std::vector<DecisionRecord> records = exportRecords(admin, bucket);
+            writeRecords(output, records);
+            if (!output)
+                throw std::runtime_error("Could not write <" + path + ">");
+            print_summary("Exported", records.size(), std::chrono::steady_clock::now() - start);
+        }
+    } catch (...) {
+        cynara_admin_finish(admin);
+        throw;
+    }
+
+    ret = cynara_admin_finish(admin);
+    check_cynara_return("cynara_admin_finish", ret);
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     int ret;
 
+    if (argc > 1 && (std::string(argv[1]) == "--import" || std::string(argv[1]) == "--export")) {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --import|--export <file> [bucket]"
+                      << std::endl;
+            return 1;
+        }
+
+        try {
+            return bulk(argv[1], argv[2], argc > 3 ? argv[3] : CYNARA_ADMIN_DEFAULT_BUCKET);
+        } catch (std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown error" << std::endl;
+        }
+        return 1;
+    }
+
     std::string client = "User::App::org.tizen.task-mgr";
     std::string user = "5001";
     std::string privilege = "http://tizen.org/privilege/appmanager.kill";